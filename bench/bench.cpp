@@ -0,0 +1,527 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <cstdio>
+#include <cstdlib>
+#include <gd.h>
+
+#include "logger.hpp"
+#include "usage.hpp"
+#include "config.hpp"
+#include "properties.hpp"
+#include "image_cache.hpp"
+#include "display.hpp"
+
+// Benchmark harness. Builds a configuration for the headless null driver with
+// one page holding every widget type and a synthetic page of N widgets on each
+// of M layers, then drives the real pipeline (blit, compositing, layout
+// render, refresh, widget updates, expressions and plugin functions) without
+// the scheduler. Results are printed one JSON object per line.
+
+struct BENCH_OPTIONS {
+	int width = 320;
+	int height = 240;
+	int bpp = 4;
+	int orientation = 0;
+	int widgets = 8;
+	int layers = 2;
+	int time = 250;
+	std::string font;
+	std::string filter;
+};
+
+static BENCH_OPTIONS options;
+
+static const std::vector<std::string> FONTS = {
+	"/usr/share/fonts/TTF/DejaVuSans.ttf",
+	"/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+	"/usr/share/fonts/dejavu/DejaVuSans.ttf",
+	"/usr/share/fonts/Adwaita/AdwaitaMono-Regular.ttf",
+};
+
+// Page numbers in generated layout
+static constexpr int WIDGET_PAGE = 0;
+static constexpr int SYNTHETIC_PAGE = 1;
+
+// Gives access to DRIVER's compositing helper.
+class PROBE : public drv::DRIVER {
+
+	public:
+		static bool compose(int page_no, int y, int x0, int x1, RGBA *out) {
+			return drv::DRIVER::compose(page_no, y, x0, x1, out);
+		}
+};
+
+// Exposes property map, so expressions can be benchmarked through P2*.
+class BENCH_PROPERTIES : public PROPERTIES {
+
+	public:
+		void set(const std::string& key, const std::string& value) {
+			this -> _properties[key] = value;
+		}
+};
+
+static bool selected(const std::string& name) {
+	return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+static void skip(const std::string& name, const std::string& reason) {
+
+	if ( selected(name))
+		std::cout << "{\"bench\":\"" << name << "\",\"skipped\":\"" << reason << "\"}" << std::endl;
+}
+
+// Runs fn until options.time milliseconds have passed (at least 3 times,
+// after 3 warm-up calls). pixels is the amount of pixels one call touches,
+// frame marks calls that produce a full frame and reports frames/s.
+template <typename F>
+static void bench(const std::string& name, double pixels, bool frame, F fn) {
+
+	if ( !selected(name))
+		return;
+
+	for ( int i = 0; i < 3; i++ )
+		fn();
+
+	uint64_t ops = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	auto deadline = t0 + std::chrono::milliseconds(options.time);
+	auto t1 = t0;
+
+	do {
+		fn();
+		ops++;
+		t1 = std::chrono::steady_clock::now();
+	} while ( ops < 3 || t1 < deadline );
+
+	double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / ops;
+
+	std::cout << std::fixed << std::setprecision(2) << "{\"bench\":\"" << name << "\",\"iterations\":" << ops <<
+		",\"ns_per_op\":" << ns << ",\"ops_per_s\":" << ( 1e9 / ns );
+
+	if ( pixels > 0 )
+		std::cout << ",\"pixels\":" << (uint64_t)pixels << ",\"ns_per_pixel\":" << ( ns / pixels );
+
+	if ( frame )
+		std::cout << ",\"fps\":" << ( 1e9 / ns );
+
+	std::cout << "}" << std::endl;
+}
+
+static bool write_png(const std::string& filename, int size, int shade) {
+
+	gdImagePtr im = gdImageCreateTrueColor(size, size);
+
+	if ( im == nullptr )
+		return false;
+
+	for ( int y = 0; y < size; y++ )
+		for ( int x = 0; x < size; x++ )
+			gdImageSetPixel(im, x, y, gdTrueColorAlpha(( x * 255 ) / size, ( y * 255 ) / size, shade, ( x + y ) % 128 ));
+
+	FILE *f = fopen(filename.c_str(), "wb");
+
+	if ( f != nullptr ) {
+		gdImageSaveAlpha(im, 1);
+		gdImagePng(im, f);
+		fclose(f);
+	}
+
+	gdImageDestroy(im);
+	return f != nullptr;
+}
+
+static std::string find_font() {
+
+	if ( !options.font.empty())
+		return std::filesystem::exists(options.font) ? options.font : "";
+
+	for ( const std::string& font : FONTS )
+		if ( std::filesystem::exists(font))
+			return font;
+
+	return "";
+}
+
+// Widget page is a 3x3 grid of cells, one widget type in each; synthetic page
+// places bars pseudo-randomly so that they overlap within and across layers,
+// with every layer above the first half transparent.
+static std::string generate_config(const std::string& dir, const std::string& font, std::vector<std::string>& types) {
+
+	// layout is in display coordinates, rotated by 90 or 270 degrees
+	int width = options.orientation % 2 ? options.height : options.width;
+	int height = options.orientation % 2 ? options.width : options.height;
+	int cw = width / 3;
+	int ch = height / 3;
+	int cs = std::max(8, std::min(cw, ch) - 4);
+
+	std::stringstream cfg;
+
+	cfg << "variables {\n" <<
+		"\tbench 0\n" <<
+		"\tbench_image '" << dir << "/a.png'\n" <<
+		"}\n\n" <<
+		"display {\n" <<
+		"\tdriver null\n" <<
+		"\twidth " << options.width << "\n" <<
+		"\theight " << options.height << "\n" <<
+		"\tbpp " << options.bpp << "\n" <<
+		"\torientation " << options.orientation << "\n" <<
+		"}\n\n";
+
+	cfg << "widget:w_bar {\n\ttype bar\n\tvalue bench\n\tmin 0\n\tmax 100\n\twidth " << cs << "\n\theight " << std::max(4, cs / 6) <<
+		"\n\tcolor '44cc44'\n\tcolorend 'ffcc00'\n\tborder 1\n}\n\n";
+	cfg << "widget:w_gauge {\n\ttype gauge\n\tvalue bench\n\tmin 0\n\tmax 100\n\twidth " << cs << "\n\theight " << cs <<
+		"\n\tneedle 1\n}\n\n";
+	cfg << "widget:w_clock {\n\ttype clock\n\twidth " << cs << "\n\theight " << cs << "\n}\n\n";
+	cfg << "widget:w_linechart {\n\ttype linechart\n\tvalue bench\n\tmin 0\n\tmax 100\n\twidth " << cs << "\n\theight " << cs / 2 <<
+		"\n\tgridlines 4\n}\n\n";
+	cfg << "widget:w_curvechart {\n\ttype curvechart\n\tvalue bench\n\tmin 0\n\tmax 100\n\twidth " << cs << "\n\theight " << cs / 2 <<
+		"\n\tfill 1\n\tgridlines 4\n}\n\n";
+	cfg << "widget:w_image {\n\ttype image\n\tfile bench_image\n\twidth " << cs << "\n\theight " << cs << "\n}\n\n";
+
+	types = { "bar", "gauge", "clock", "linechart", "curvechart", "image" };
+
+	if ( !font.empty()) {
+		cfg << "widget:w_ttf {\n\ttype ttf\n\tfont '" << font << "'\n\tsize " << std::max(6, cs / 6) <<
+			"\n\ttext 'value ' . bench\n}\n\n";
+		types.push_back("ttf");
+	}
+
+	uint32_t seed = 0x2545f491;
+	auto rnd = [&seed](int max) {
+		seed = seed * 1664525 + 1013904223;
+		return max > 0 ? (int)(( seed >> 8 ) % max ) : 0;
+	};
+
+	for ( int l = 0; l < options.layers; l++ ) {
+		for ( int i = 0; i < options.widgets; i++ ) {
+
+			int w = std::max(4, width / 8 + rnd(width / 4));
+			int h = std::max(4, height / 8 + rnd(height / 4));
+			char color[8];
+			snprintf(color, sizeof(color), "%06x", rnd(0xffffff));
+
+			cfg << "widget:s_" << l << "_" << i << " {\n\ttype bar\n\tvalue bench\n" <<
+				"\tmin 0\n\tmax 100\n\twidth " << w << "\n\theight " << h << "\n\tcolor '" << color << "'\n" <<
+				"\tbgcolor '202020'\n\topacity " << ( l == 0 ? "1.0" : "0.5" ) << "\n}\n\n";
+		}
+	}
+
+	cfg << "layout {\n\tdefault " << WIDGET_PAGE << "\n\n\tpage:" << WIDGET_PAGE << " {\n";
+
+	for ( size_t i = 0; i < types.size(); i++ )
+		cfg << "\t\tw_" << types[i] << " " << ( i % 3 ) * cw + 2 << "," << ( i / 3 ) * ch + 2 << "\n";
+
+	cfg << "\t}\n\n\tpage:" << SYNTHETIC_PAGE << " {\n";
+
+	seed = 0x9e3779b9;
+
+	for ( int l = 0; l < options.layers; l++ ) {
+
+		cfg << "\t\tlayer:" << l << " {\n";
+
+		for ( int i = 0; i < options.widgets; i++ )
+			cfg << "\t\t\ts_" << l << "_" << i << " " << rnd(width * 3 / 4) << "," << rnd(height * 3 / 4) << "\n";
+
+		cfg << "\t\t}\n";
+	}
+
+	cfg << "\t}\n}\n";
+
+	std::string filename = dir + "/bench.conf";
+	std::ofstream f(filename);
+	f << cfg.str();
+	return filename;
+}
+
+static double bump() {
+
+	static int value = 0;
+	value = ( value + 1 ) % 100;
+	CONFIG::variables["bench"] = (double)value;
+	return value;
+}
+
+static std::vector<widget::WIDGET*> page_widgets(int page_no) {
+
+	std::vector<widget::WIDGET*> ret;
+
+	for ( auto& [n, layer] : display -> layout -> pages[page_no].layers )
+		for ( auto& link : layer.widgets )
+			if ( auto *w = link.get_ptr(); w != nullptr )
+				ret.push_back(w);
+
+	return ret;
+}
+
+static void bench_pipeline() {
+
+	double pixels = (double)display -> pwidth() * display -> pheight();
+	auto synthetic = page_widgets(SYNTHETIC_PAGE);
+
+	if ( !display -> page_number(SYNTHETIC_PAGE))
+		return;
+
+	for ( auto *w : synthetic ) {
+		w -> invalidate();
+		w -> update();
+	}
+
+	display -> layout -> render();
+	display -> refresh();
+
+	std::vector<RGBA> bitmap(display -> width() * display -> height(), RGBA(0x40, 0x80, 0xc0, 0xff));
+	CANVAS::SURFACE surface;
+
+	bench("blit", pixels, false, [&]() {
+		display -> blit(surface, RECT(display -> width(), display -> height()), bitmap.data());
+	});
+
+	bench("blend", pixels, false, [&]() {
+		for ( int y = 0; y < display -> pheight(); y++ )
+			for ( int x = 0; x < display -> pwidth(); x++ )
+				display -> driver -> rgb(x, y);
+	});
+
+	std::vector<RGBA> row(display -> pwidth());
+
+	bench("compose", pixels, false, [&]() {
+		for ( int y = 0; y < display -> pheight(); y++ )
+			PROBE::compose(SYNTHETIC_PAGE, y, 0, display -> pwidth(), row.data());
+	});
+
+	bench("layout_render", pixels, false, [&]() {
+		display -> layout -> render();
+	});
+
+	bench("refresh", pixels, true, [&]() {
+		display -> refresh();
+	});
+
+	bench("frame", pixels, true, [&]() {
+		bump();
+		for ( auto *w : synthetic ) {
+			w -> invalidate();
+			w -> update();
+		}
+		display -> layout -> render();
+		display -> refresh();
+	});
+}
+
+static void bench_widgets(const std::string& dir, const std::vector<std::string>& types, bool font) {
+
+	std::string images[2] = { dir + "/a.png", dir + "/b.png" };
+	int image = 0;
+
+	for ( const std::string& type : types ) {
+
+		widget::WIDGET *w = ( *display -> widgets )["w_" + type];
+
+		if ( w == nullptr ) {
+			skip("widget_" + type, "widget failed to initialize");
+			continue;
+		}
+
+		w -> invalidate();
+		w -> update();
+
+		double pixels = (double)w -> width() * w -> height();
+
+		bench("widget_" + type, pixels, false, [&]() {
+			if ( type == "image" )
+				CONFIG::variables["bench_image"] = images[++image % 2];
+			else bump();
+			w -> invalidate();
+			w -> update();
+		});
+
+		if ( type == "image" )
+			bench("widget_image_decode", pixels, false, [&]() {
+				IMAGE_CACHE::clear();
+				CONFIG::variables["bench_image"] = images[++image % 2];
+				w -> invalidate();
+				w -> update();
+			});
+	}
+
+	if ( !font )
+		skip("widget_ttf", "no font found, use --font");
+}
+
+static void bench_properties() {
+
+	BENCH_PROPERTIES p;
+	p.set("constant", "42");
+	p.set("number", "bench * 2 + 1");
+	p.set("string", "'value ' . bench");
+	p.set("boolean", "bench > 50");
+
+	bench("P2I_constant", 0, false, [&]() { p.P2I("constant"); });
+	bench("P2I_expression", 0, false, [&]() { p.P2I("number"); });
+	bench("P2N_expression", 0, false, [&]() { p.P2N("number"); });
+	bench("P2S_expression", 0, false, [&]() { p.P2S("string"); });
+	bench("P2B_expression", 0, false, [&]() { p.P2B("boolean"); });
+}
+
+static void bench_plugins() {
+
+	static const std::vector<std::pair<std::string, std::string>> calls = {
+		{ "cpu_load", "cpu::load()" },
+		{ "mem_used", "mem::used('mb')" },
+		{ "fs_free", "fs::free('/')" },
+		{ "uname_hostname", "uname::hostname()" },
+		{ "uptime", "uptime()" },
+		{ "netinfo_operstate", "netinfo::operstate('lo')" },
+	};
+
+	for ( const auto& [name, call] : calls ) {
+
+		try {
+			expr::expression e(call);
+			e.evaluate(&CONFIG::functions, &CONFIG::variables);
+			bench("function_" + name, 0, false, [&]() {
+				e.evaluate(&CONFIG::functions, &CONFIG::variables);
+			});
+		} catch ( const std::exception& e ) {
+			skip("function_" + name, "evaluation failed");
+		}
+	}
+
+	for ( auto it = display -> plugins -> begin(); it != display -> plugins -> end(); ++it ) {
+
+		auto& p = it -> second;
+		bench("plugin_update_" + it -> first, 0, false, [&]() { p -> update(); });
+	}
+}
+
+static bool parse_int(usage_t& usage, const std::string& key, int& value, int min, int max) {
+
+	if ( !usage[key] )
+		return true;
+
+	try {
+		value = std::stoi(usage[key].value);
+	} catch ( ... ) {
+		value = min - 1;
+	}
+
+	if ( value < min || value > max ) {
+		std::cerr << "error: " << key << " must be between " << min << " and " << max << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char **argv) {
+
+	usage_t usage = {
+		.args = { argc, argv },
+		.info = {
+			.name          = "lcd2-bench",
+			.version       = "1.0",
+			.author        = "Oskari Rauta",
+			.copyright     = "2024-2026, Oskari Rauta",
+			.usage         = "[options]",
+			.options_title = "\nOptions:",
+		},
+		.options = {
+			{ "help",    { .key = "h", .word = "help",    .desc = "show this help and exit" }},
+			{ "width",   { .key = "W", .word = "width",   .desc = "framebuffer width (320)",
+			               .flag = usage_t::REQUIRED, .name = "pixels" }},
+			{ "height",  { .key = "H", .word = "height",  .desc = "framebuffer height (240)",
+			               .flag = usage_t::REQUIRED, .name = "pixels" }},
+			{ "bpp",     { .key = "b", .word = "bpp",     .desc = "framebuffer bytes per pixel, 2, 3 or 4 (4)",
+			               .flag = usage_t::REQUIRED, .name = "bytes" }},
+			{ "orientation", { .key = "r", .word = "orientation", .desc = "display orientation, 0 to 3 (0)",
+			               .flag = usage_t::REQUIRED, .name = "value" }},
+			{ "widgets", { .key = "n", .word = "widgets", .desc = "widgets per layer on synthetic page (8)",
+			               .flag = usage_t::REQUIRED, .name = "count" }},
+			{ "layers",  { .key = "m", .word = "layers",  .desc = "layers on synthetic page (2)",
+			               .flag = usage_t::REQUIRED, .name = "count" }},
+			{ "time",    { .key = "t", .word = "time",    .desc = "minimum run time of each benchmark in ms (250)",
+			               .flag = usage_t::REQUIRED, .name = "ms" }},
+			{ "font",    { .key = "f", .word = "font",    .desc = "ttf font for ttf widget benchmark",
+			               .flag = usage_t::REQUIRED, .name = "file" }},
+			{ "filter",  { .key = "o", .word = "only",    .desc = "run only benchmarks whose name contains string",
+			               .flag = usage_t::REQUIRED, .name = "string" }},
+		}
+	};
+
+	if ( usage["help"] ) {
+		std::cout << usage << "\n" << usage.help() << "\n" << std::endl;
+		return 0;
+	}
+
+	if ( !parse_int(usage, "width", options.width, 16, 8192) || !parse_int(usage, "height", options.height, 16, 8192) ||
+		!parse_int(usage, "bpp", options.bpp, 2, 4) || !parse_int(usage, "orientation", options.orientation, 0, 3) ||
+		!parse_int(usage, "widgets", options.widgets, 1, 1000) ||
+		!parse_int(usage, "layers", options.layers, 1, 64) || !parse_int(usage, "time", options.time, 1, 600000))
+		return 1;
+
+	if ( usage["font"] )
+		options.font = usage["font"].value;
+
+	if ( usage["filter"] )
+		options.filter = usage["filter"].value;
+
+	logger::loglevel(logger::error);
+
+	std::string dir = ( std::filesystem::temp_directory_path() / "lcd2-bench-XXXXXX" ).string();
+
+	if ( mkdtemp(dir.data()) == nullptr ) {
+		std::cerr << "error: failed to create temporary directory" << std::endl;
+		return 1;
+	}
+
+	std::string font = find_font();
+	std::vector<std::string> types;
+	int cs = std::max(8, std::min(options.width / 3, options.height / 3) - 4);
+
+	if ( !write_png(dir + "/a.png", cs, 0x40) || !write_png(dir + "/b.png", cs, 0xc0)) {
+		std::cerr << "error: failed to write images to " << dir << std::endl;
+		std::filesystem::remove_all(dir);
+		return 1;
+	}
+
+	std::string filename = generate_config(dir, font, types);
+	CONFIG *cfg = nullptr;
+	int ret = 0;
+
+	try {
+		cfg = new CONFIG(filename);
+		display = new DISPLAY(cfg);
+		display -> prepare();
+	} catch ( const std::exception& e ) {
+		std::cerr << "error: " << e.what() << std::endl;
+		ret = 1;
+	}
+
+	delete cfg;
+
+	if ( ret == 0 ) {
+
+		std::cout << "{\"width\":" << options.width << ",\"height\":" << options.height << ",\"bpp\":" << options.bpp <<
+			",\"orientation\":" << options.orientation << ",\"widgets\":" << options.widgets << ",\"layers\":" << options.layers << ",\"time_ms\":" << options.time <<
+			"}" << std::endl;
+
+		bench_pipeline();
+		bench_widgets(dir, types, !font.empty());
+		bench_properties();
+		bench_plugins();
+	}
+
+	delete display;
+	display = nullptr;
+
+	std::filesystem::remove_all(dir);
+	return ret;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <map>
+#include <list>
+#include <vector>
+#include <cstdint>
+
+#include "rgb.hpp"
+#include "rect.hpp"
+
+// Rendered content of layout pages. A page is stored as surfaces, one for
+// every widget placement in layout order, each holding only the pixels of its
+// own rectangle in panel orientation. Pages are composited from surfaces
+// found through a grid of panel cells, so areas without widgets cost nothing.
+//
+// Surfaces are allocated on first use only for the active page and a few
+// recently used, warm, pages; when more are needed the least recently used
+// page is dropped. Dropped page is empty when it is used again and must be
+// rendered before it is shown.
+
+class CANVAS {
+
+	public:
+
+		// Cell size of grid index, in panel pixels
+		static constexpr int GRID = 32;
+
+		struct SURFACE {
+
+			RECT rect;			// on panel, empty until drawn
+			std::vector<RGBA> pixels;	// rect sized, premultiplied
+			uint64_t generation = 0;	// of widget bitmap copied here
+		};
+
+		// Where a bitmap of rect, in display coordinates, lands on panel;
+		// worked out by DISPLAY::place() and kept while rect stays the same
+		struct PLACEMENT {
+
+			RECT rect;			// bitmap on display
+			RECT clip;			// visible part of rect, in bitmap coordinates
+			RECT panel;			// visible part of rect on panel
+			int offset = 0;			// surface index of bitmap pixel 0,0
+			int step_x = 0, step_y = 0;	// surface index increment per bitmap x and y
+			bool inside = true;		// rect is within display
+			bool placed = false;
+
+			bool at(const RECT& r) const;
+		};
+
+		struct PAGE {
+
+			std::vector<SURFACE> surfaces;		// in compositing order
+			std::vector<std::vector<uint16_t>> cells;	// surfaces intersecting each grid cell
+			std::vector<std::vector<uint16_t>> bands;	// surfaces intersecting each row of cells
+			bool indexed = false;
+		};
+
+	private:
+
+		int _width = 0;
+		int _height = 0;
+		size_t _warm = 2;
+		std::map<int, size_t> _surfaces;	// surface count of every page
+		std::map<int, PAGE> _pages;		// allocated pages
+		std::list<int> _lru;			// allocated pages, most recently used first
+		std::vector<std::vector<RGBA>> _pool;	// pixel buffers of dropped pages
+
+		void drop(int page_no);
+		void index(PAGE& page);
+
+	public:
+
+		// panel size, surface count of pages and count of pages kept
+		// allocated in addition to the one in use
+		void init(int width, int height, const std::map<int, size_t>& surfaces, size_t warm);
+		void clear();
+
+		bool empty() const;
+		bool contains(int page_no) const;
+		bool allocated(int page_no) const;
+		// true if pages and their surface counts are as given
+		bool fits(const std::map<int, size_t>& surfaces) const;
+		size_t warm() const;
+
+		// Surfaces of page, allocated on demand; marks page most recently
+		// used. nullptr if page is not in layout.
+		PAGE* page(int page_no);
+
+		// Composes pixels x0..x1 of panel row y of page into out, over
+		// background colour; span must be within panel. False if page is
+		// not in layout.
+		bool compose(int page_no, int y, int x0, int x1, RGBA *out);
+};
@@ -3,6 +3,7 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #include "tsl/ordered_map.h"
 #include "rva/variant.hpp"
@@ -23,22 +24,41 @@ class CONFIG {
 	using MAP = tsl::ordered_map<std::string, NODE>;
 	using VECTOR = std::vector<std::string>;
 
+	// Included file as it was when configuration was parsed
+	struct INCLUDE {
+		std::string path;
+		uint64_t size;		// UINT64_MAX if file did not exist
+		int64_t mtime;		// nanoseconds
+
+		static INCLUDE stat(const std::string& path);
+		bool operator ==(const INCLUDE& other) const = default;
+	};
+
 	static bool parse_option(const std::string& section, std::string key, std::string value, std::vector<std::string>* allowed = nullptr);
 	static bool evaluate_string(const std::string& section, const std::string& key, const std::string& expr, std::string& value, bool to_lower);
 	static bool evaluate_double(const std::string& section, const std::string& key, const std::string& expr, double& value);
 	static bool evaluate_int(const std::string& section, const std::string& key, const std::string& expr, int& value);
 	static bool evaluate_result(const std::string& section, const std::string& key, const std::string& expr, expr::RESULT &result);
 
+	// true if nodes have same content, in same order
+	static bool same(const NODE& a, const NODE& b);
+	// true if any key or value of node refers to name as a whole word
+	static bool mentions(const NODE& node, const std::string& name);
+
 	private:
 
 	std::ifstream fd;
 
 	void load();
 	void parse();
+	bool load_cache(uint64_t hash, uint64_t size);
+	void save_cache(uint64_t hash, uint64_t size);
 
 	protected:
 
 	std::string _filename;
+	std::string _cache;
+	std::vector<INCLUDE> _includes;
 	MAP _cfg;
 
 	public:
@@ -56,7 +76,10 @@ class CONFIG {
 
 	NODE* operator [](const std::string& name);
 
-	CONFIG(const std::string& filename);
+	// With cache set, parsed configuration is stored there and loaded
+	// from it instead of parsing for as long as the file and the files it
+	// includes stay the same.
+	CONFIG(const std::string& filename, const std::string& cache = "");
 	~CONFIG();
 
 	friend std::ostream& operator <<(std::ostream& os, CONFIG const& c);
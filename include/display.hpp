@@ -9,6 +9,8 @@
 #include "tsl/ordered_map.h"
 #include "properties.hpp"
 #include "rgb.hpp"
+#include "rect.hpp"
+#include "canvas.hpp"
 #include "orientation.hpp"
 #include "driver_classes.hpp"
 #include "widget_classes.hpp"
@@ -16,7 +18,9 @@
 #include "timer.hpp"
 #include "action.hpp"
 #include "layout.hpp"
+#include "transition.hpp"
 #include "scheduler.hpp"
+#include "watcher.hpp"
 
 class DISPLAY : public PROPERTIES {
 
@@ -25,6 +29,7 @@ class DISPLAY : public PROPERTIES {
 
 	friend class LAYOUT;
 	friend class SCHEDULER;
+	friend class TRANSITION;
 
 	protected:
 
@@ -37,17 +42,25 @@ class DISPLAY : public PROPERTIES {
 		std::atomic<int> _page{0};
 		int _width, _height;
 
-		std::vector<RGBA> new_layer();
+		// Frame drivers show instead of current page while a transition runs
+		const std::vector<RGBA> *_frame = nullptr;
+		TRANSITION _transition;
 
 	private:
 		bool _clean_up = true;
 
+		// Configuration as it was last read, compared against on reload
+		std::string _config_file;
+		std::string _config_cache;
+		CONFIG::MAP _config;
+
 		void init_variables(CONFIG::MAP* cfg);
 		void init_display(CONFIG::MAP* cfg);
+		void init_plugins(CONFIG::MAP* cfg);
 		void init_timers(CONFIG::MAP* cfg);
 		void init_widgets(CONFIG::MAP* cfg);
 		void init_layout(CONFIG::MAP* cfg);
-		void init_canvas();
+		void init_canvas(bool keep = false);
 		void init_driver(const std::string& driver, const std::string& device);
 		void init_scheduler(CONFIG::MAP* cfg);
 
@@ -55,7 +68,7 @@ class DISPLAY : public PROPERTIES {
 
 	public:
 
-		std::map<int, std::map<int, std::vector<RGBA>>> canvas;
+		CANVAS canvas;
 		std::vector<LAYOUT::WIDGET_LINK> updated_widgets;
 
 		drv::DRIVER *driver = nullptr;
@@ -65,6 +78,7 @@ class DISPLAY : public PROPERTIES {
 		common::lowercase_map<TIMER> timers;
 		LAYOUT *layout = nullptr;
 		SCHEDULER *scheduler = nullptr;
+		WATCHER *watcher = nullptr;
 
 		int width();
 		int height();
@@ -81,13 +95,32 @@ class DISPLAY : public PROPERTIES {
 		// page_number(), which throws when the page is absent from the canvas).
 		int page_current() { return this -> _page; }
 		void refresh();
-		void add_pixel(int x, int y, int page, int layer, RGBA color);
+
+		// Works out where a bitmap of rect lands on panel. Coordinates are in
+		// display orientation; rect is clipped to display and surface covers
+		// only its visible part on panel.
+		void place(CANVAS::PLACEMENT& placement, const RECT& rect);
+
+		// Places surface as placement tells and copies bitmap of size rect to
+		// it, or empties surface when bitmap is not set. Returns false if any
+		// part of rect was outside of display.
+		bool blit(CANVAS::SURFACE& surface, const CANVAS::PLACEMENT& placement, const RGBA *bitmap);
+		bool blit(CANVAS::SURFACE& surface, const RECT& rect, const RGBA *bitmap);
+
+		// Prunes layout and allocates canvas if not yet done; run before first
+		// frame by the scheduler, or by anything driving the pipeline without one.
+		void prepare();
 
 		bool setpage(int page_no);
 		bool goodbye();
 		bool threading();
 		void run();
 
+		// Reads configuration file again and re-creates only what changed
+		// since it was last read; driver and canvas are kept. Returns false
+		// if file could not be read or nothing changed.
+		bool reload();
+
 		DISPLAY& operator *() { return *this; };
 		DISPLAY* operator ->() { return this; }
 
@@ -25,6 +25,10 @@ namespace drv {
 			virtual RGBA blend(int x, int y);
 			std::vector<RGBA> canvas;
 
+			// Composes pixels x0..x1 of panel row y of page into out, or of
+			// transition frame while one runs; false if page is not on canvas.
+			static bool compose(int page_no, int y, int x0, int x1, RGBA *out);
+
 			// One-shot: forces the next full-screen blit to write and send
 			// every pixel, bypassing the per-pixel dirty/delta check. Set at
 			// construction so the first frame fully repaints the panel rather
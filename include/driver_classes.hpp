@@ -3,3 +3,4 @@
 #include "driver.hpp"
 #include "drivers/dpf.hpp"
 #include "drivers/drm.hpp"
+#include "drivers/null.hpp"
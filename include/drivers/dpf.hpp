@@ -32,12 +32,16 @@ namespace drv {
 			// area needing re-drawing
 			RECT bounds;
 
+			// page composed row by row for a refresh, reused between refreshes
+			std::vector<RGBA> composed;
+
 			void rect_init(RECT& rect);
 			void rect_reset(RECT& rect);
 			std::vector<unsigned char> rect_args(const RECT& rect);
 
 			void set_pixel(int x, int y, const RGBA& c);
 			void fill(const RGBA& c);
+			bool compose_rows(int y0, int y1, int x0, int x1);
 			int  wrap_scsi(const std::vector<unsigned char>& cmd, const DIR& dir, std::vector<unsigned char>* data);
 			void ax_blit(std::vector<RGBA>& buf, const RECT& rect);
 			void ax_backlight(int value);
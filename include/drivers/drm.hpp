@@ -2,6 +2,7 @@
 
 #include <string>
 #include <cstdint>
+#include <vector>
 
 #include <xf86drm.h>
 #include <xf86drmMode.h>
@@ -36,6 +37,9 @@ class DRM : public drv::DRIVER {
         int _backlight_max = 100;
         bool _backlight_disabled = false;
 
+        // composed row, reused between blits
+        std::vector<RGBA> _row;
+
         void open_device();
         void find_connector();
         void create_framebuffer();
@@ -43,6 +47,7 @@ class DRM : public drv::DRIVER {
         void destroy_framebuffer();
         void find_backlight_path(const std::string& configured_path);
         void write_pixel(int x, int y, const RGBA& c);
+        bool blit_row(int page_no, int y, int x0, int x1, bool force);
         void mark_dirty();
 
     public:
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "rgb.hpp"
+#include "driver.hpp"
+#include "rect.hpp"
+
+namespace drv {
+
+// Headless driver without any hardware. Frames are composited into a memory
+// framebuffer of 2 (RGB565), 3 (RGB888) or 4 (RGBA8888) bytes per pixel and,
+// when device is set, written out after every blit that changed pixels:
+//
+//   device ending in .png    frame is written as PNG
+//   any other path           raw framebuffer bytes
+//   "-"                      raw frames streamed to stdout
+//
+// A %d (or %0Nd) in device is replaced with the frame number, producing one
+// file per frame; without it, PNG output overwrites the same file and raw
+// output is appended to it as a stream of frames.
+class NUL : public drv::DRIVER {
+
+    private:
+
+        std::string _dev;
+        int _bpp = 4;
+        int _fd = -1;
+        bool _png = false;
+        bool _numbered = false;
+        uint64_t _frames = 0;
+        std::vector<uint8_t> _buffer;
+
+        // composed row, reused between draws
+        std::vector<RGBA> _row;
+
+        void open_output();
+        void write_pixel(int x, int y, const RGBA& c);
+        RGBA read_pixel(int x, int y) const;
+        bool draw(int x, int y, int width, int height, bool force);
+        void present();
+        void write_png(const std::string& filename);
+        void write_raw(int fd);
+
+    public:
+
+        virtual const std::string name() override { return "NULL"; }
+        virtual const std::string device() override { return _dev; }
+        virtual const int BPP() override;
+        virtual ~NUL() override;
+
+        virtual void backlight(int value) override;
+        virtual void blit(int x, int y, int width, int height) override;
+        virtual void blit(const std::vector<RECT>& rects) override;
+        virtual void blit_fullscreen() override;
+        virtual void clear() override;
+
+        uint64_t frames() const { return _frames; }
+        const std::vector<uint8_t>& framebuffer() const { return _buffer; }
+
+        NUL(const std::string& device, int backlight, int bpp, int& width, int& height);
+};
+
+}
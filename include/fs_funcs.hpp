@@ -9,4 +9,8 @@ namespace fs {
 	bool is_accessible(const std::string& filename);
 
 	bool is_readable(const std::string& filename);
+
+	// true for files on kernel pseudo filesystems (proc, sysfs, ...) whose
+	// content is generated on read and whose mtime/size do not track it
+	bool is_pseudo(const std::string& filename);
 }
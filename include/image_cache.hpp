@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "rgb.hpp"
+
+// Cache of decoded, scaled and converted images shared by all image widgets.
+// Entries are keyed by the file's identity (path, inode, mtime, size) and by
+// every property that affects the resulting bitmap, so an unchanged file
+// costs a stat() and a lookup instead of a decode. When a cache directory is
+// configured, decoded bitmaps are also persisted in its images subdirectory as
+// raw files that are mmap'ed back on the next start; least recently used files
+// are removed when they grow over max_disk_bytes.
+class IMAGE_CACHE {
+
+	public:
+
+		struct KEY {
+
+			std::string path;
+			ino_t inode = 0;
+			int64_t mtime = 0;
+			int64_t size = 0;
+			int width = 0;
+			int height = 0;
+			double scale = 1.0;
+			bool inverted = false;
+			double opacity = 1.0;
+			int center = 0; // display width when centered, 0 otherwise
+
+			bool operator ==(const KEY& other) const = default;
+
+			const std::string to_string() const;
+			uint64_t hash() const;
+		};
+
+		struct ENTRY {
+
+			int width = 0;
+			int height = 0;
+			std::vector<RGBA> bitmap;
+		};
+
+		static constexpr size_t max_bytes = 32 * 1024 * 1024;
+		static constexpr size_t max_disk_bytes = 64 * 1024 * 1024;
+
+		static bool stat(const std::string& path, KEY& key);
+		static std::shared_ptr<const ENTRY> find(const KEY& key);
+		static void store(const KEY& key, const std::shared_ptr<const ENTRY>& entry);
+		static void clear();
+
+		static const std::string directory();
+		static void directory(const std::string& path);
+
+	private:
+
+		static std::mutex _m;
+		static std::list<std::pair<KEY, std::shared_ptr<const ENTRY>>> _entries;
+		static size_t _bytes;
+		static std::string _directory;
+
+		// Persisted files by key hash, listed once per directory
+		struct DISK_ENTRY {
+
+			int64_t used = 0; // ns since epoch, file's mtime
+			size_t size = 0;
+		};
+
+		static std::map<uint64_t, DISK_ENTRY> _files;
+		static size_t _disk_bytes;
+		static bool _scanned;
+
+		static std::shared_ptr<const ENTRY> load(const KEY& key);
+		static void save(const KEY& key, const ENTRY& entry);
+		static void scan(const std::string& dir);
+		static void prune(const std::string& dir, uint64_t keep);
+		static void evict();
+};
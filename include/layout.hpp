@@ -2,8 +2,12 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 #include "expr/expression.hpp"
+#include "rgb.hpp"
+#include "canvas.hpp"
+#include "transition.hpp"
 #include "widget_classes.hpp"
 #include "plugin.hpp"
 
@@ -11,6 +15,7 @@ class LAYOUT {
 
 	private:
 		std::vector<int> parse_page_sequence(const std::string& s);
+		void parse_transition(const std::string& key, const CONFIG::NODE& value, TRANSITION::STYLE& style, const std::string& where);
 
 	public:
 
@@ -18,6 +23,7 @@ class LAYOUT {
 
 			std::string name;
 			int x, y;
+			widget::WIDGET *ptr = nullptr;
 
 			widget::WIDGET* get_ptr();
 			bool reloads();
@@ -48,6 +54,7 @@ class LAYOUT {
 			std::vector<std::string> timers;
 			std::string on_enter;
 			std::string on_exit;
+			TRANSITION::STYLE transition;
 
 			void update_widgets();
 			bool enter();
@@ -60,17 +67,34 @@ class LAYOUT {
 			}
 		};
 
+		// Widget placement resolved against widgets and canvas by compile();
+		// rendering walks these without looking up anything by name.
+		struct DRAW {
+
+			std::string name;
+			widget::WIDGET *ptr;
+			int layer;			// layer on display canvas
+			int x, y;
+			CANVAS::PLACEMENT placement;	// redone when widget is resized
+			bool reported = false;		// placement problem has been logged
+		};
+
 		std::map<int, PAGE> pages;
+		std::map<int, std::vector<DRAW>> compiled;
 		std::vector<std::string> timers;
 		std::vector<int> page_sequence;
 		int prev_page_index = -1;
 		int next_page_index = 0;
 		int default_page = 0;
+		TRANSITION::STYLE transition = { .type = TRANSITION::NONE, .duration = 300 };
 
 		const std::string type() { return "config"; }
 		const std::string name() { return "layout"; }
 
 		const std::string dump();
+		void compile();
+		// transition played when entering page_no
+		TRANSITION::STYLE transition_to(int page_no);
 		void render(int *forced_page = nullptr, bool all = false);
 		bool update();
 
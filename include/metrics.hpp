@@ -0,0 +1,104 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+// Always-on latency instrumentation. A HISTOGRAM keeps log-linear buckets
+// (HDR style: each power of two is split into SUB_BUCKETS linear steps,
+// bounding relative error to 1/SUB_BUCKETS) of durations in nanoseconds;
+// recording is a few relaxed atomic increments and never blocks.
+//
+// METRICS is a registry of named histograms and counters, rendered in the
+// Prometheus text format. When an endpoint is set, a thread serves it either
+// by rewriting a file periodically or, for "unix:/path", by answering every
+// connection on a UNIX stream socket (plain or HTTP/1.0 when the client sends
+// a GET request).
+class HISTOGRAM {
+
+	public:
+
+		static constexpr int SUB_BITS = 3;
+		static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+		static constexpr int MIN_EXP = 10;	// ~1 µs, everything below lands in bucket 0
+		static constexpr int MAX_EXP = 35;	// ~34 s, everything above lands in last bucket
+		static constexpr int BUCKETS = 1 + ( MAX_EXP - MIN_EXP + 1 ) * SUB_BUCKETS;
+
+		void record(uint64_t ns);
+		void record(std::chrono::steady_clock::duration d);
+
+		uint64_t count() const;
+		uint64_t sum() const;
+		// upper bound of bucket holding q-quantile, in nanoseconds
+		uint64_t quantile(double q) const;
+		// amount of samples not greater than ns, ns must be a power of two
+		uint64_t count_below(uint64_t ns) const;
+
+		static int index(uint64_t ns);
+		static uint64_t upper_bound(int index);
+
+	private:
+
+		std::array<std::atomic<uint64_t>, BUCKETS> _buckets{};
+		std::atomic<uint64_t> _count{0};
+		std::atomic<uint64_t> _sum{0};
+};
+
+class METRICS {
+
+	public:
+
+		struct FAMILY {
+			std::string help;
+			std::string label;
+			std::map<std::string, std::unique_ptr<HISTOGRAM>> series;
+		};
+
+		struct COUNTER {
+			std::string help;
+			std::atomic<uint64_t> value{0};
+		};
+
+	private:
+
+		std::mutex _m;
+		std::map<std::string, FAMILY> _histograms;
+		std::map<std::string, std::unique_ptr<COUNTER>> _counters;
+
+		std::string _endpoint;
+		int _interval = 10000;
+		int _fd = -1;
+		std::jthread _thread;
+
+		void file_loop(std::stop_token token);
+		void socket_loop(std::stop_token token);
+		void write_file();
+		void serve(int client);
+
+	public:
+
+		// Returns histogram for label value of family, creating it on first use.
+		// The reference stays valid for the lifetime of METRICS.
+		HISTOGRAM& histogram(const std::string& family, const std::string& label = "", const std::string& value = "");
+		std::atomic<uint64_t>& counter(const std::string& name);
+
+		void describe(const std::string& name, const std::string& help);
+
+		const std::string endpoint() const;
+		bool listen(const std::string& endpoint, int interval = 10000);
+		void close();
+
+		const std::string dump();
+
+		METRICS() {}
+		~METRICS();
+
+		METRICS(const METRICS&) = delete;
+		METRICS& operator =(const METRICS&) = delete;
+};
@@ -14,6 +14,8 @@ class plugin::FS : public plugin::PLUGIN {
 
 		virtual const std::string type() const override { return "fs"; }
 
+		static void configure(CONFIG::MAP *cfg);
+
 		explicit FS(CONFIG::MAP *cfg);
 		~FS();
 
@@ -26,4 +28,10 @@ class plugin::FS : public plugin::PLUGIN {
 	static expr::VARIABLE fn_used_pretty(const expr::FUNCTION_ARGS& args);
 	static expr::VARIABLE fn_free_pretty(const expr::FUNCTION_ARGS& args);
 	static expr::VARIABLE fn_available_pretty(const expr::FUNCTION_ARGS& args);
+
+	static expr::VARIABLE fn_count(const expr::FUNCTION_ARGS& args);
+	static expr::VARIABLE fn_list(const expr::FUNCTION_ARGS& args);
+	static expr::VARIABLE fn_mount(const expr::FUNCTION_ARGS& args);
+	static expr::VARIABLE fn_device(const expr::FUNCTION_ARGS& args);
+	static expr::VARIABLE fn_type(const expr::FUNCTION_ARGS& args);
 };
@@ -2,6 +2,7 @@
 
 #include <mutex>
 #include <thread>
+#include <chrono>
 #include "common.hpp"
 #include "lowercase_map.hpp"
 #include "config.hpp"
@@ -10,9 +11,15 @@
 
 class plugin::MEMINFO : public plugin::PLUGIN {
 
+	protected:
+
+		std::chrono::milliseconds last_updated = std::chrono::milliseconds(0);
+
 	public:
 
 		virtual const std::string type() const override { return "meminfo"; }
+		virtual bool update() override;
+		virtual int interval() override;
 
 		explicit MEMINFO(CONFIG::MAP *cfg);
 		~MEMINFO();
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Keeps a /proc file open and re-reads it with pread() into a buffer that is
+// reused between samples, growing only when the file outgrows it. The scan
+// helpers work on string_views into that buffer and do not allocate.
+class PROCFILE {
+
+	private:
+
+		std::string _path;
+		int _fd = -1;
+		std::vector<char> _buf;
+		size_t _len = 0;
+
+	public:
+
+		bool read();
+		bool is_open() const;
+		const std::string& path() const;
+		std::string_view data() const;
+
+		// splits next line off data into line, returns false at end of data
+		static bool getline(std::string_view& data, std::string_view& line);
+		// skips leading blanks and parses an unsigned number, advancing s past it
+		static uint64_t number(std::string_view& s);
+		// skips leading blanks and returns next blank separated word, advancing s past it
+		static std::string_view word(std::string_view& s);
+
+		explicit PROCFILE(const std::string& path, size_t size = 4096);
+		~PROCFILE();
+
+		PROCFILE(const PROCFILE&) = delete;
+		PROCFILE& operator =(const PROCFILE&) = delete;
+};
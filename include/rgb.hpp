@@ -4,6 +4,20 @@
 #include <stdexcept>
 #include <utility>
 #include <vector>
+#include <span>
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+
+struct gdImageStruct;
+
+// Pixel is a plain 4 byte value: trivially copyable, compared as a single
+// 32 bit word, and converted to framebuffer formats without allocating.
+//
+// Widget bitmaps and layer canvases hold premultiplied alpha: colour
+// channels are already scaled by A, so compositing a pixel over another is
+// a single multiply-add per channel. Colours parsed from configuration are
+// straight alpha until premultiplied().
 
 struct RGBA {
 
@@ -30,25 +44,68 @@ struct RGBA {
 		unsigned char B = 0x00;
 		unsigned char A = 0xff;
 
-		RGBA() noexcept;
-		RGBA(int gdTrueColorPixel, bool inverted, double alpha = 1.0);
+		constexpr RGBA() noexcept = default;
 		RGBA(const std::string& hex, bool forced = false);
-		RGBA(unsigned char R, unsigned char G, unsigned char B, unsigned char A) :
+		constexpr RGBA(unsigned char R, unsigned char G, unsigned char B, unsigned char A) :
 			R(R), G(G), B(B), A(A) {};
-		explicit RGBA(Raw rgba) : R(rgba.R), G(rgba.G), B(rgba.B), A(rgba.A) {};
+		constexpr explicit RGBA(Raw rgba) : R(rgba.R), G(rgba.G), B(rgba.B), A(rgba.A) {};
 
-		bool operator ==(const RGBA& other);
-		bool operator ==(const RGBA& other) const;
-		bool operator !=(const RGBA& other);
-		bool operator !=(const RGBA& other) const;
+		constexpr uint32_t value() const { return std::bit_cast<uint32_t>(*this); }
 
-		RGBA& operator =(const RGBA& other);
+		constexpr bool operator ==(const RGBA& other) const { return this -> value() == other.value(); }
+		constexpr bool operator !=(const RGBA& other) const { return this -> value() != other.value(); }
 
 		static const std::string hex_normalizer(const std::string& hex);
 		static bool check_color(const std::string& hex);
 		double alpha();
 
-		std::vector<unsigned char> RGB565() const;
+		constexpr uint16_t RGB565() const {
+			return (( this -> R & 0xf8 ) << 8 ) | (( this -> G & 0xfc ) << 3 ) | ( this -> B >> 3 );
+		}
+
+		constexpr uint32_t XRGB8888() const {
+			return ((uint32_t)this -> R << 16 ) | ((uint32_t)this -> G << 8 ) | this -> B;
+		}
+
+		// colour channels scaled by alpha
+		constexpr RGBA premultiplied() const {
+			return RGBA(RGBA::mul(this -> R, this -> A), RGBA::mul(this -> G, this -> A), RGBA::mul(this -> B, this -> A), this -> A);
+		}
+
+		// x * y / 255, rounded
+		static constexpr unsigned char mul(unsigned int x, unsigned int y) {
+			unsigned int v = x * y + 128;
+			return ( v + ( v >> 8 )) >> 8;
+		}
+
+		// this over dst, both premultiplied
+		constexpr RGBA over(const RGBA& dst) const {
+			unsigned int t = 0xff - this -> A;
+			return RGBA(this -> R + RGBA::mul(dst.R, t), this -> G + RGBA::mul(dst.G, t),
+				this -> B + RGBA::mul(dst.B, t), this -> A + RGBA::mul(dst.A, t));
+		}
+
+		// Reads truecolor gd image into bitmap as premultiplied pixels,
+		// inverting colours and applying opacity on the way
+		static void from_gd(gdImageStruct *image, std::vector<RGBA>& bitmap, bool inverted = false, double opacity = 1.0);
+
+		// Inverts colours and applies opacity to straight alpha bitmap, then
+		// premultiplies it, in a single pass
+		static void finish(std::span<RGBA> bitmap, bool inverted, double opacity);
+
+		// Bulk conversions, dst must be atleast as long as src
+		static void to_RGB565(std::span<const RGBA> src, std::span<uint16_t> dst);
+		static void to_XRGB8888(std::span<const RGBA> src, std::span<uint32_t> dst);
+		static void premultiply(std::span<const RGBA> src, std::span<RGBA> dst);
+
+		// dst = a * ( 256 - weight ) / 256 + b * weight / 256 per channel, weight
+		// 0..256; worked on as plain bytes so that it vectorizes
+		static void mix(std::span<const RGBA> a, std::span<const RGBA> b, std::span<RGBA> dst, unsigned int weight);
+
+		// index of first pixel that differs, or length of shorter span if none does
+		static size_t mismatch(std::span<const RGBA> a, std::span<const RGBA> b);
 
 		unsigned char GD_alpha();
 };
+
+static_assert(sizeof(RGBA) == 4 && std::is_trivially_copyable_v<RGBA>, "RGBA must be a plain 32 bit value");
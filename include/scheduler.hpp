@@ -5,8 +5,14 @@
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <vector>
 
 #include "layout.hpp"
+#include "metrics.hpp"
+#include "thread_pool.hpp"
 
 class DISPLAY;
 
@@ -25,34 +31,112 @@ class SCHEDULER {
         // Stop requested by signal or display shutdown
         std::atomic_bool _stop{false};
 
+        // Configuration reload requested by signal, done by data thread
+        std::atomic_bool _reload{false};
+
         // Protects CONFIG::variables and plugin/timer state across threads.
         // Data thread holds it exclusively during plugin+timer updates.
         // Render thread holds it during widget expression evaluation.
         std::mutex _data_mutex;
 
+        // Signalled by wake() to cut a render/cycle sleep short, e.g. when a
+        // watched file changed and affected widgets should redraw right away.
+        std::mutex _wake_mutex;
+        std::condition_variable _wake_cv;
+        bool _wake = false;
+
+        // Stage histograms and counters, resolved once from metrics
+        struct STAGES {
+            HISTOGRAM* plugins;
+            HISTOGRAM* timers;
+            HISTOGRAM* widgets;
+            HISTOGRAM* render;
+            HISTOGRAM* refresh;
+            HISTOGRAM* frame;
+            HISTOGRAM* data_wait;
+            HISTOGRAM* render_wait;
+            std::atomic<uint64_t>* cycles;
+            std::atomic<uint64_t>* frames;
+            std::atomic<uint64_t>* overruns;
+            std::atomic<uint64_t>* data_cycles;
+            std::atomic<uint64_t>* deferred;
+            std::atomic<uint64_t>* widget_overruns;
+            std::atomic<uint64_t>* degraded;
+        } _stages;
+
+        // Per-widget update state, keyed by widget so that the render
+        // thread does not look it up by name every frame
+        struct WIDGET_STATS {
+            HISTOGRAM* histogram = nullptr;
+            int deferred = 0;       // frames in a row left out by budget
+            int overruns = 0;       // drawing updates in a row over WIDGET_OVERRUN
+            uint64_t total_overruns = 0;
+            bool degraded = false;
+        };
+        std::unordered_map<const widget::WIDGET*, WIDGET_STATS> _widget_stats;
+
+        // Update duration histogram of every plugin, resolved on first update
+        std::unordered_map<const plugin::PLUGIN*, HISTOGRAM*> _plugin_histograms;
+
+        // Update order of widgets in current frame
+        std::vector<const LAYOUT::DRAW*> _order;
+
+        // Page of page sequence that was rendered ahead of its switch, or
+        // NO_PAGE; consumed by claim_prerendered() when the page is entered
+        static constexpr int NO_PAGE = -2;
+        std::atomic<int> _prerendered{NO_PAGE};
+
+        // Loads fonts and images of widgets at startup
+        std::unique_ptr<THREAD_POOL> _pool;
+
         // Worker threads (threaded mode only)
         std::jthread _data_thread;
         std::jthread _render_thread;
 
         bool run_once();
+        void reload_config();
 
         void update_plugins();
         void update_timers();
+        bool update_widget(const LAYOUT::DRAW& d, WIDGET_STATS& stats);
         bool update_widgets();
+        bool update_widgets(int page, std::unordered_set<const widget::WIDGET*>* updated = nullptr);
+        std::chrono::milliseconds until_page_switch(int page);
+        std::chrono::milliseconds next_sync(int page, bool& ahead);
+        std::chrono::milliseconds next_timer_sync(int page);
+        void prerender();
+        size_t preload(int page, std::unordered_set<const widget::WIDGET*>& seen);
 
         void data_loop(std::stop_token token);
         void render_loop(std::stop_token token);
 
+        void sleep_until(std::chrono::steady_clock::time_point tp);
+
         void run_threaded();
         void run_unthreaded();
 
     public:
 
+        // Always-on timing instrumentation of the pipeline
+        METRICS metrics;
+
         bool threading() const;
 
+        void wake();
+
+        // True when page was prerendered and only needs a refresh on switch
+        bool claim_prerendered(int page);
+
+        // Requests configuration reload; safe to call from a signal handler
+        void reload();
+
         void exit_loop(bool value);
         bool exit_loop() const;
 
+        // True when a page transition towards page, run on data thread, should
+        // be cut short as exit, reload or another page switch is waiting for it
+        bool interrupt(int page);
+
         void run();
 
         SCHEDULER(DISPLAY* display, bool threaded = true);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+// Fixed set of worker threads running submitted jobs in submission order.
+// Jobs must not throw; an exception that escapes one is logged and dropped.
+// Destroying the pool discards jobs that have not started and waits for the
+// running ones to finish.
+class THREAD_POOL {
+
+	private:
+
+		std::mutex _m;
+		std::condition_variable_any _cv;
+		std::condition_variable _idle;
+		std::deque<std::function<void()>> _jobs;
+		size_t _running = 0;
+		std::vector<std::jthread> _threads;
+
+		void worker(std::stop_token token);
+
+	public:
+
+		void submit(std::function<void()> job);
+		// blocks until every submitted job has finished
+		void wait();
+		size_t size() const;
+
+		// threads of 0 uses amount of cpu cores
+		THREAD_POOL(size_t threads = 0);
+		~THREAD_POOL();
+
+		THREAD_POOL(const THREAD_POOL&) = delete;
+		THREAD_POOL& operator =(const THREAD_POOL&) = delete;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <string>
+
+// Time of the current frame. The scheduler captures it once at the start of
+// every render and data cycle, on the thread running the cycle; widgets and
+// timers read it instead of asking the clock themselves, so everything
+// updated in one cycle sees the same time. Threads that have not captured a
+// tick read the clock directly.
+//
+// Broken-down local time is converted once per second and thread, and time
+// zone is re-read once a minute.
+//
+// Widgets and timers may align their updates to wall clock boundaries instead
+// of counting interval from their previous update.
+
+class TICK {
+
+	private:
+
+		struct STATE {
+
+			bool captured = false;
+			std::chrono::steady_clock::time_point steady;
+			std::chrono::system_clock::time_point wall;
+		};
+
+		struct LOCAL {
+
+			std::time_t second = -1;
+			std::tm tm = {};
+			std::chrono::steady_clock::time_point zone_read;
+		};
+
+		static thread_local STATE _state;
+		static thread_local LOCAL _local;
+
+	public:
+
+		enum ALIGN { NONE, SECOND, MINUTE, INTERVAL };
+
+		// snapshot for calling thread while in scope, for work done outside
+		// of scheduler's cycles; thread reads the clock again afterwards
+		struct SCOPE {
+
+			SCOPE() { TICK::capture(); }
+			~SCOPE() { TICK::release(); }
+
+			SCOPE(const SCOPE&) = delete;
+			SCOPE& operator =(const SCOPE&) = delete;
+		};
+
+		// takes a new snapshot for calling thread
+		static void capture();
+		// snapshot of a coming moment, for drawing ahead of it
+		static void capture(std::chrono::milliseconds wall);
+		// calling thread reads the clock again
+		static void release();
+
+		static std::chrono::steady_clock::time_point steady();
+		static std::chrono::system_clock::time_point wall();
+		// steady time of a wall clock moment, by current offset of the clocks
+		static std::chrono::steady_clock::time_point steady(std::chrono::milliseconds wall);
+		// wall clock since epoch, as widgets and timers keep their update times
+		static std::chrono::milliseconds millis();
+		static const std::tm& local();
+
+		// When an update of interval ms, previously done at last, is due.
+		// Aligned updates fall on whole seconds, minutes or multiples of
+		// interval since epoch; interval is rounded up to whole units.
+		static std::chrono::milliseconds next(std::chrono::milliseconds last, int interval, ALIGN align);
+
+		static bool parse(const std::string& name, ALIGN& align);
+		static std::string name(ALIGN align);
+};
@@ -4,6 +4,7 @@
 #include <mutex>
 
 #include "properties.hpp"
+#include "tick.hpp"
 
 class DISPLAY;
 class SCHEDULER;
@@ -25,8 +26,18 @@ class TIMER : public PROPERTIES {
 		std::string _name;
 
 		std::chrono::milliseconds last_updated = std::chrono::milliseconds(0);
+		TICK::ALIGN _sync = TICK::NONE;
 		std::mutex _m;
 
+	public:
+
+		// Page switch done by action, classified once when timer is set up
+		enum PAGE_ACTION { NO_PAGE_ACTION, PAGE_NEXT, PAGE_PREV, PAGE_SET };
+
+	protected:
+
+		PAGE_ACTION _page_action = NO_PAGE_ACTION;
+
 	public:
 
 		virtual const std::string type() const;
@@ -35,8 +46,12 @@ class TIMER : public PROPERTIES {
 		const std::string dump();
 		const std::vector<std::string> expressions() const;
 		int interval();
+		TICK::ALIGN sync() const;
+		// When next update is due, wall clock milliseconds
+		std::chrono::milliseconds next_update();
 		bool active();
 		const std::string get_action() const;
+		PAGE_ACTION page_action() const;
 
 		const bool is_global(LAYOUT* layout) const;
 		const bool on_page(LAYOUT* layout, int page_no) const;
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Opt-in frame trace recorder. While enabled, TRACE_SPAN records a complete
+// event (name, optional argument, start and duration) into a ring buffer of
+// the calling thread; rings are single-writer and never lock, and the oldest
+// events are overwritten when a ring is full. The recorded spans are written
+// as Chrome trace-event JSON, loadable in chrome://tracing and Perfetto, when
+// SIGUSR1 is received and when tracing is disabled at exit.
+//
+// When tracing is disabled a span costs one relaxed atomic load.
+class TRACE {
+
+	public:
+
+		class SPAN {
+
+			private:
+				const char *_name = nullptr;
+				const char *_arg = nullptr;
+				uint64_t _start = 0;
+
+			public:
+				SPAN(const char *name, const char *arg = nullptr) {
+
+					if ( TRACE::_enabled.load(std::memory_order_relaxed)) {
+						this -> _name = name;
+						this -> _arg = arg;
+						this -> _start = TRACE::now();
+					}
+				}
+
+				SPAN(const char *name, const std::string& arg) : SPAN(name, arg.c_str()) {}
+
+				~SPAN() {
+					this -> end();
+				}
+
+				// records span now instead of at end of scope
+				void end() {
+
+					if ( this -> _name != nullptr )
+						TRACE::record(this -> _name, this -> _arg, this -> _start, TRACE::now());
+
+					this -> _name = nullptr;
+				}
+
+				SPAN(const SPAN&) = delete;
+				SPAN& operator =(const SPAN&) = delete;
+		};
+
+		static bool enabled();
+		static void enable(const std::string& filename, size_t events_per_thread = 16384);
+		static void disable();
+
+		// names calling thread in the trace
+		static void thread_name(const std::string& name);
+		static bool dump();
+
+		static uint64_t now() {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+	private:
+
+		static std::atomic<bool> _enabled;
+
+		static void record(const char *name, const char *arg, uint64_t start, uint64_t end);
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(...) TRACE::SPAN TRACE_CONCAT(_trace_span_, __LINE__)(__VA_ARGS__)
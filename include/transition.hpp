@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "rgb.hpp"
+
+// Animates page switch by compositing flattened frames of the previous and
+// the next page straight into the driver for a short while. Widgets are not
+// rendered during a transition, pages are shown as they are on canvas.
+
+class TRANSITION {
+
+	public:
+
+		enum TYPE { INHERIT, NONE, FADE, SLIDE_LEFT, SLIDE_RIGHT, WIPE_LEFT, WIPE_RIGHT };
+
+		struct STYLE {
+
+			TYPE type = TRANSITION::INHERIT;
+			int duration = 0; // milliseconds, 0 inherits
+		};
+
+	private:
+
+		std::vector<RGBA> _from;
+		std::vector<RGBA> _to;
+		std::vector<RGBA> _frame;
+		bool _slow = false;
+
+		bool flatten(int page_no, std::vector<RGBA>& out);
+		void compose(TYPE type, double t);
+
+	public:
+
+		// Shows page to over page from, blocking for style's duration. Returns
+		// false if transition was not played or it was cut short; caller
+		// refreshes display with page to in any case.
+		bool run(int from, int to, const STYLE& style);
+
+		static bool parse(const std::string& name, TYPE& type);
+		static std::string name(TYPE type);
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <cstdint>
+
+// Shared inotify based file-watch service. Consumers subscribe a path and
+// compare its generation counter against the one they saw last; the counter
+// is bumped when the file is closed after writing or renamed into place
+// (IN_CLOSE_WRITE, IN_MOVED_TO), or when it is removed. Parent directories
+// are watched so atomic replace-by-rename is seen as well.
+//
+// Generations are unique across the service, so a path that is dropped and
+// subscribed again never reports a generation a consumer has already seen.
+// Both subscribe() and generation() return 0 for paths that cannot be
+// watched, including paths on proc, sysfs and network filesystems where
+// inotify does not report changes; callers then fall back to their own
+// polling.
+class WATCHER {
+
+	private:
+
+		struct DIR_WATCH {
+			int wd = -1;
+			std::map<std::string, uint64_t> files; // file name -> generation
+		};
+
+		int _fd = -1;
+		uint64_t _serial = 0;
+		std::mutex _m;
+		std::map<std::string, DIR_WATCH> _dirs;
+		std::map<int, std::string> _wds;
+		std::set<std::string> _unwatchable;
+		std::function<void()> _notify = nullptr;
+		std::jthread _thread;
+
+		void watch_loop(std::stop_token token);
+		void process(const char *buf, size_t len);
+
+	public:
+
+		bool available() const;
+
+		uint64_t subscribe(const std::string& path);
+		uint64_t generation(const std::string& path);
+
+		void on_change(const std::function<void()>& fn);
+
+		WATCHER();
+		~WATCHER();
+};
@@ -4,6 +4,8 @@
 #include <utility>
 #include <chrono>
 #include <vector>
+#include <functional>
+#include <cstdint>
 
 #include "common.hpp"
 #include "config.hpp"
@@ -11,6 +13,7 @@
 #include "lowercase_map.hpp"
 #include "expr/expression.hpp"
 #include "rgb.hpp"
+#include "tick.hpp"
 
 class DISPLAY;
 
@@ -29,6 +32,26 @@ class widget {
 
 			friend class DISPLAY;
 
+			public:
+
+				// FNV-1a of the values a widget is drawn from
+				class INPUTS {
+
+					private:
+						uint64_t _hash = 0xcbf29ce484222325ULL;
+
+						void add(const void *data, size_t size);
+
+					public:
+						INPUTS& operator <<(const std::string& s);
+						INPUTS& operator <<(const char *s);
+						INPUTS& operator <<(int i);
+						INPUTS& operator <<(double d);
+						INPUTS& operator <<(bool b);
+
+						uint64_t hash() const;
+				};
+
 			protected:
 				std::string _name;
 				int _width = 0;
@@ -38,12 +61,27 @@ class widget {
 				bool _needs_update = false;
 				bool _needs_draw = false;
 				int _interval = -1;
+				int _priority = -1;
+				int _sync = -1;
+				bool _degraded = false;
 				int _use_cycles = -1;
 				int _cycle = -1;
 				bool _was_visible = false;
+				uint64_t _inputs = 0;
+				bool _inputs_valid = false;
+				uint64_t _generation = 0;
 
 				std::chrono::milliseconds last_updated = std::chrono::milliseconds(0);
 
+				// True if hash of the values widget is drawn from, evaluated
+				// once per update, differs from that of previous update, or
+				// there is no bitmap to show. Widgets that do not depend on
+				// them alone (scrolling charts) do not use it.
+				bool inputs_changed(const INPUTS& in);
+
+				// Ends update(): bitmap that was drawn gets a new generation
+				bool drawn();
+
 			public:
 				std::vector<RGBA> bitmap;
 
@@ -53,6 +91,15 @@ class widget {
 				virtual bool reloads();
 				virtual bool use_cycles();
 				virtual int interval();
+				// Update order within frame, higher first, 0..10
+				virtual int priority();
+				// Wall clock boundary that updates fall on
+				virtual TICK::ALIGN sync();
+				// When next update is due by interval, wall clock milliseconds
+				virtual std::chrono::milliseconds next_update();
+				// True if widget takes time only from the frame tick, so that
+				// it can be drawn ahead of a tick that is still coming
+				virtual bool draws_ahead() const;
 				virtual int width() const;
 				virtual int height() const;
 				virtual int previous_width() const;
@@ -60,8 +107,24 @@ class widget {
 				virtual bool center();
 				virtual bool visible();
 				virtual bool needs_draw() const;
+				// Changes whenever update() draws a new bitmap; unique among
+				// widgets, so that a surface can tell if it holds the current
+				// bitmap of its widget, also after widgets were re-created
+				uint64_t generation() const;
 				virtual bool update() = 0;
 				virtual bool time_to_update();
+				// forces next update() to re-evaluate and draw regardless of
+				// interval and inputs
+				virtual void invalidate();
+				// Returns a job that loads assets of widget (fonts, images) so that
+				// its first update does not have to, or an empty function when
+				// there is nothing to load. Properties are evaluated by the caller,
+				// the job itself is safe to run on any thread.
+				virtual std::function<void()> preload();
+				// Switches to a cheaper way of drawing when updates keep taking
+				// longer than the scheduler allows, e.g. by leaving out
+				// anti-aliasing. False if widget has nothing cheaper.
+				virtual bool degrade();
 
 				WIDGET();
 				virtual ~WIDGET();
@@ -15,10 +15,21 @@ class widget::BAR : public widget::WIDGET {
 
 	protected:
 
+		// Properties bar is drawn from, evaluated once per update
+		struct VALUES {
+			int value, smooth, low, high, min, max, width, height;
+			std::string direction, color, colorend, colorlow, colorhigh, bgcolor, bordercolor;
+			double scale, opacity;
+			bool hollow, inverted, border, center;
+
+			void hash(INPUTS& in) const;
+		};
+
 		bool _needs_draw = false;
-		bool render();
+		bool render(const VALUES& v);
 		int smoother(int value, int smooth);
-		bool value_did_change();
+		void evaluate(VALUES& v);
+		void read_value(const VALUES& v);
 
 	public:
 		virtual const std::string type() const override { return "bar"; }
@@ -11,12 +11,25 @@ class widget::CLOCK : public widget::WIDGET {
 
 	protected:
 
+		// Properties and local time clock is drawn from, evaluated once
+		// per update
+		struct VALUES {
+			int width, height, handwidth, hour, minute, second;
+			std::string facecolor, rimcolor, hourcolor, minutecolor, secondcolor, tickcolor;
+			bool ticks, minuteticks;
+
+			void hash(INPUTS& in) const;
+		};
+
 		bool _needs_draw = false;
-		bool render();
+		void evaluate(VALUES& v);
+		bool render(const VALUES& v);
 
 	public:
 		virtual const std::string type() const override { return "clock"; }
 		virtual bool update() override;
+		virtual bool degrade() override;
+		virtual bool draws_ahead() const override;
 
 		explicit CLOCK(const std::string& name, CONFIG::MAP *cfg);
 		~CLOCK();
@@ -15,9 +15,18 @@ class widget::GAUGE : public widget::WIDGET {
 
 	protected:
 
+		// Properties gauge is drawn from, evaluated once per update
+		struct VALUES {
+			int value, min, max, width, height, startangle, sweepangle, low, high, linewidth;
+			std::string fgcolor, trackcolor, bgcolor, needlecolor, colorlow, colorhigh;
+			bool needle;
+
+			void hash(INPUTS& in) const;
+		};
+
 		bool _needs_draw = false;
-		bool render();
-		bool value_did_change();
+		bool render(const VALUES& v);
+		void evaluate(VALUES& v);
 
 	public:
 		virtual const std::string type() const override { return "gauge"; }
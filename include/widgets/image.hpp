@@ -1,22 +1,32 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
 
 #include "common.hpp"
 #include "lowercase_map.hpp"
 #include "config.hpp"
 #include "widget.hpp"
+#include "image_cache.hpp"
 
 class widget::IMAGE : public widget::WIDGET {
 
 	protected:
 
 		bool _needs_draw = false;
+		IMAGE_CACHE::KEY _key;
+		std::shared_ptr<const IMAGE_CACHE::ENTRY> _image = nullptr;
+		std::string _watch_path;
+		uint64_t _watch_generation = 0;
+
 		bool render(const std::string &filename);
+		bool make_key(const std::string& filename, IMAGE_CACHE::KEY& key);
+		std::shared_ptr<const IMAGE_CACHE::ENTRY> decode(const std::string& filename, const IMAGE_CACHE::KEY& key);
 
 	public:
 		virtual const std::string type() const override { return "image"; }
 		virtual bool update() override;
+		virtual std::function<void()> preload() override;
 
 		explicit IMAGE(const std::string& name, CONFIG::MAP *cfg);
 		~IMAGE();
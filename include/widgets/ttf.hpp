@@ -11,12 +11,25 @@ class widget::TTF : public widget::WIDGET {
 
 	protected:
 
+		// Properties text is drawn from, evaluated once per update
+		struct VALUES {
+			std::string text, font, color, align, debugbordercolor, shadowcolor, outlinecolor;
+			double size, scale, opacity;
+			int width, height, offset, shadowoffset;
+			bool inverted, debugborder, shadow, outline, center;
+
+			void hash(INPUTS& in) const;
+		};
+
 		bool _needs_draw = false;
-		bool render(const std::string& text, const std::string& font);
+		void evaluate(VALUES& v);
+		bool render(const VALUES& v);
 
 	public:
 		virtual const std::string type() const override { return "ttf"; }
 		virtual bool update() override;
+		virtual bool degrade() override;
+		virtual std::function<void()> preload() override;
 
 		explicit TTF(const std::string& name, CONFIG::MAP *cfg);
 		~TTF();
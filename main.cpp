@@ -5,6 +5,7 @@
 #include "config.hpp"
 #include "display.hpp"
 #include "usage.hpp"
+#include "trace.hpp"
 
 #define LCD2_VERSION "1.2.1"
 
@@ -14,6 +15,12 @@ static void die_handler(int signum) {
 		display->scheduler->exit_loop(true);
 }
 
+static void reload_handler(int signum) {
+	logger::info << SIG::to_string(signum) << " received, reloading configuration" << std::endl;
+	if ( display != nullptr && display -> scheduler != nullptr )
+		display -> scheduler -> reload();
+}
+
 int main(int argc, char **argv) {
 
 	usage_t usage = {
@@ -38,6 +45,10 @@ int main(int argc, char **argv) {
 			{ "debug",    { .key = "d", .word = "debug",    .desc = "debug log level (very noisy)" }},
 			{ "silent",   { .key = "s", .word = "silent",   .desc = "suppress startup banner" }},
 			{ "quiet",    { .key = "q", .word = "quiet",    .desc = "suppress logging to errors only" }},
+			{ "cache",    {             .word = "cache",    .desc = "parsed configuration cache, used while configuration is unchanged",
+			                .flag = usage_t::REQUIRED, .name = "file" }},
+			{ "trace",    {             .word = "trace",    .desc = "record frame trace, written on SIGUSR1 and exit",
+			                .flag = usage_t::REQUIRED, .name = "file" }},
 		}
 	};
 
@@ -75,16 +86,19 @@ int main(int argc, char **argv) {
 
 	SIG handler = {
 		.TERM = die_handler,
-		.HUP  = die_handler,
+		.HUP  = reload_handler,
 		.INT  = die_handler,
 		.QUIT = die_handler,
 	};
 	handler.install();
 
+	if ( usage["trace"] )
+		TRACE::enable(usage["trace"].value);
+
 	CONFIG *cfg = nullptr;
 
 	try {
-		cfg = new CONFIG(config_file);
+		cfg = new CONFIG(config_file, usage["cache"] ? usage["cache"].value : "");
 	} catch ( const std::exception& e ) {
 		logger::error["config"] << e.what() << std::endl;
 		if ( cfg != nullptr ) delete cfg;
@@ -102,6 +116,7 @@ int main(int argc, char **argv) {
 	delete cfg;
 
 	display->run();
+	TRACE::disable();
 
 	delete display;
 	return 0;
@@ -0,0 +1,189 @@
+#include <algorithm>
+
+#include "logger.hpp"
+#include "layout.hpp"
+#include "canvas.hpp"
+
+bool CANVAS::PLACEMENT::at(const RECT& r) const {
+
+	return this -> placed && this -> rect.min.x == r.min.x && this -> rect.min.y == r.min.y &&
+		this -> rect.max.x == r.max.x && this -> rect.max.y == r.max.y;
+}
+
+void CANVAS::init(int width, int height, const std::map<int, size_t>& surfaces, size_t warm) {
+
+	this -> clear();
+	this -> _width = width;
+	this -> _height = height;
+	this -> _surfaces = surfaces;
+	this -> _warm = warm;
+}
+
+void CANVAS::clear() {
+
+	this -> _pages.clear();
+	this -> _lru.clear();
+	this -> _pool.clear();
+	this -> _surfaces.clear();
+}
+
+bool CANVAS::empty() const {
+
+	return this -> _surfaces.empty();
+}
+
+bool CANVAS::contains(int page_no) const {
+
+	return this -> _surfaces.contains(page_no);
+}
+
+bool CANVAS::allocated(int page_no) const {
+
+	return this -> _pages.contains(page_no);
+}
+
+bool CANVAS::fits(const std::map<int, size_t>& surfaces) const {
+
+	return this -> _surfaces == surfaces;
+}
+
+size_t CANVAS::warm() const {
+
+	return this -> _warm;
+}
+
+void CANVAS::drop(int page_no) {
+
+	auto it = this -> _pages.find(page_no);
+
+	if ( it == this -> _pages.end())
+		return;
+
+	for ( SURFACE& s : it -> second.surfaces )
+		if ( s.pixels.capacity() > 0 )
+			this -> _pool.push_back(std::move(s.pixels));
+
+	this -> _pages.erase(it);
+	this -> _lru.remove(page_no);
+
+	logger::vverbose["display"] << "released canvas of " << LAYOUT::page_name(page_no) << std::endl;
+}
+
+CANVAS::PAGE* CANVAS::page(int page_no) {
+
+	if ( auto it = this -> _pages.find(page_no); it != this -> _pages.end()) {
+
+		if ( this -> _lru.front() != page_no ) {
+			this -> _lru.remove(page_no);
+			this -> _lru.push_front(page_no);
+		}
+
+		return &it -> second;
+	}
+
+	auto count = this -> _surfaces.find(page_no);
+
+	if ( count == this -> _surfaces.end())
+		return nullptr;
+
+	while ( !this -> _lru.empty() && this -> _lru.size() > this -> _warm )
+		this -> drop(this -> _lru.back());
+
+	PAGE& page = this -> _pages[page_no];
+	page.surfaces.resize(count -> second);
+
+	// reuse buffers of dropped pages, they are resized when drawn
+	for ( SURFACE& s : page.surfaces ) {
+
+		if ( this -> _pool.empty())
+			break;
+
+		s.pixels = std::move(this -> _pool.back());
+		s.pixels.clear();
+		this -> _pool.pop_back();
+	}
+
+	this -> _pool.clear();
+	this -> _lru.push_front(page_no);
+
+	logger::vverbose["display"] << "allocated canvas of " << LAYOUT::page_name(page_no) << std::endl;
+	return &page;
+}
+
+// Lists every surface in cells and bands it intersects; surfaces are added in
+// order, so lists stay in compositing order.
+void CANVAS::index(PAGE& page) {
+
+	int cols = ( this -> _width + GRID - 1 ) / GRID;
+	int rows = ( this -> _height + GRID - 1 ) / GRID;
+
+	page.cells.assign(cols * rows, {});
+	page.bands.assign(rows, {});
+
+	for ( size_t i = 0; i < page.surfaces.size(); i++ ) {
+
+		const RECT& r = page.surfaces[i].rect;
+
+		if ( r.max.x <= r.min.x || r.max.y <= r.min.y )
+			continue;
+
+		for ( int cy = r.min.y / GRID; cy <= ( r.max.y - 1 ) / GRID; cy++ ) {
+
+			page.bands[cy].push_back(i);
+
+			for ( int cx = r.min.x / GRID; cx <= ( r.max.x - 1 ) / GRID; cx++ )
+				page.cells[cy * cols + cx].push_back(i);
+		}
+	}
+
+	page.indexed = true;
+}
+
+bool CANVAS::compose(int page_no, int y, int x0, int x1, RGBA *out) {
+
+	PAGE *page = this -> page(page_no);
+
+	if ( page == nullptr )
+		return false;
+
+	if ( x1 <= x0 || y < 0 || y >= this -> _height )
+		return true;
+
+	std::fill(out, out + ( x1 - x0 ), RGBA(RGBA::BL.R, RGBA::BL.G, RGBA::BL.B, 0x00));
+
+	if ( !page -> indexed )
+		this -> index(*page);
+
+	// a single cell covers pixel lookups, wider spans walk the whole band
+	int cy = y / GRID;
+	const std::vector<uint16_t>& list = x0 / GRID == ( x1 - 1 ) / GRID ?
+		page -> cells[cy * (( this -> _width + GRID - 1 ) / GRID ) + x0 / GRID] : page -> bands[cy];
+
+	for ( uint16_t i : list ) {
+
+		const SURFACE& s = page -> surfaces[i];
+
+		if ( y < s.rect.min.y || y >= s.rect.max.y )
+			continue;
+
+		int sx0 = std::max(x0, s.rect.min.x);
+		int sx1 = std::min(x1, s.rect.max.x);
+		const RGBA *src = s.pixels.data() + ( y - s.rect.min.y ) * ( s.rect.max.x - s.rect.min.x ) + ( sx0 - s.rect.min.x );
+		RGBA *dst = out + ( sx0 - x0 );
+
+		for ( int n = sx1 - sx0; n > 0; n--, src++, dst++ ) {
+
+			switch ( src -> A ) {
+				case 0: break;
+				case 0xff:
+					*dst = *src;
+					break;
+				default: // premultiplied
+					*dst = src -> over(*dst);
+					dst -> A = 0xff;
+			}
+		}
+	}
+
+	return true;
+}
@@ -3,8 +3,10 @@
 #include <sstream>
 #include <cstring>
 #include <cerrno>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <variant>
 #include <iomanip>
 #include <algorithm>
@@ -348,7 +350,7 @@ static void parse_array(std::ifstream& fd, CONFIG::VECTOR& cfg, bool full_lines)
 
 // TODO: check un-even braces and parentheses
 
-static void parse_cfg(std::ifstream& fd, CONFIG::MAP& cfg, bool root) {
+static void parse_cfg(std::ifstream& fd, CONFIG::MAP& cfg, bool root, std::vector<CONFIG::INCLUDE>* includes = nullptr) {
 
 	std::string line;
 
@@ -435,7 +437,13 @@ static void parse_cfg(std::ifstream& fd, CONFIG::MAP& cfg, bool root) {
 
 				logger::error["config"] << "invalid include directive in config, filename not specified" << std::endl;
 				continue;
-			} else if ( !std::filesystem::exists(value)) {
+			}
+
+			// also missing files, cache turns stale once they appear
+			if ( includes != nullptr )
+				includes -> push_back(CONFIG::INCLUDE::stat(value));
+
+			if ( !std::filesystem::exists(value)) {
 
 				logger::error["config"] << "ignoring include directive, file " << value << " does not exists" << std::endl;
 				continue;
@@ -464,7 +472,7 @@ static void parse_cfg(std::ifstream& fd, CONFIG::MAP& cfg, bool root) {
 
 			logger::verbose["config"] << "including file " << value << std::endl;
 
-			parse_cfg(_fd, cfg, true);
+			parse_cfg(_fd, cfg, true, includes);
 
 			if ( _fd.is_open())
 				_fd.close();
@@ -631,10 +639,11 @@ void CONFIG::parse() {
 	line_no = 0;
 	unnamed_cnt = 0;
 	this -> _cfg.clear();
+	this -> _includes.clear();
 	this -> fd.seekg(0);
 
 	try {
-		parse_cfg(this -> fd, this -> _cfg, true);
+		parse_cfg(this -> fd, this -> _cfg, true, &this -> _includes);
 	} catch ( const std::runtime_error& e ) {
 
 		if( this -> fd.is_open())
@@ -732,13 +741,95 @@ CONFIG::NODE* CONFIG::operator [](const std::string& name) {
 	return &(this -> _cfg[name]);
 }
 
-CONFIG::CONFIG(const std::string& filename) {
+bool CONFIG::same(const NODE& a, const NODE& b) {
+
+	if ( a.index() != b.index())
+		return false;
+
+	if ( std::holds_alternative<std::string>(a))
+		return std::get<std::string>(a) == std::get<std::string>(b);
+
+	if ( std::holds_alternative<VECTOR>(a))
+		return std::get<VECTOR>(a) == std::get<VECTOR>(b);
+
+	const MAP& ma = std::get<MAP>(a);
+	const MAP& mb = std::get<MAP>(b);
+
+	if ( ma.size() != mb.size())
+		return false;
+
+	for ( auto it = ma.begin(), jt = mb.begin(); it != ma.end(); ++it, ++jt )
+		if ( it -> first != jt -> first || !CONFIG::same(it -> second, jt -> second))
+			return false;
+
+	return true;
+}
+
+static bool mentions_word(const std::string& s, const std::string& word) {
+
+	auto is_word = [](char ch) { return std::isalnum((unsigned char)ch) || ch == '_'; };
+
+	for ( size_t pos = s.find(word); pos != std::string::npos; pos = s.find(word, pos + 1))
+		if (( pos == 0 || !is_word(s[pos - 1])) && ( pos + word.size() == s.size() || !is_word(s[pos + word.size()])))
+			return true;
+
+	return false;
+}
+
+bool CONFIG::mentions(const NODE& node, const std::string& name) {
+
+	if ( name.empty())
+		return false;
+
+	if ( std::holds_alternative<std::string>(node))
+		return mentions_word(std::get<std::string>(node), name);
+
+	if ( std::holds_alternative<VECTOR>(node)) {
+
+		for ( const std::string& s : std::get<VECTOR>(node))
+			if ( mentions_word(s, name))
+				return true;
+
+		return false;
+	}
+
+	for ( const auto& [k, v] : std::get<MAP>(node))
+		if ( mentions_word(k, name) || CONFIG::mentions(v, name))
+			return true;
+
+	return false;
+}
+
+CONFIG::CONFIG(const std::string& filename, const std::string& cache) {
 
 	this -> _filename = filename;
+	this -> _cache = cache;
 
 	try {
 		this -> load();
-		this -> parse();
+
+		if ( this -> _cache.empty())
+			this -> parse();
+		else {
+
+			std::stringstream ss;
+			ss << this -> fd.rdbuf();
+			this -> fd.clear();
+
+			std::string source = ss.str();
+			uint64_t hash = 0xcbf29ce484222325ULL;
+
+			for ( unsigned char ch : source ) {
+				hash ^= ch;
+				hash *= 0x100000001b3ULL;
+			}
+
+			if ( !this -> load_cache(hash, source.size())) {
+				this -> parse();
+				this -> save_cache(hash, source.size());
+			}
+		}
+
 	} catch ( const std::runtime_error& e ) {
 		throw e;
 	}
@@ -849,6 +940,264 @@ bool CONFIG::evaluate_result(const std::string& section, const std::string& key,
 	return true;
 }
 
+CONFIG::INCLUDE CONFIG::INCLUDE::stat(const std::string& path) {
+
+	struct stat st;
+
+	if ( ::stat(path.c_str(), &st) != 0 )
+		return { .path = path, .size = UINT64_MAX, .mtime = 0 };
+
+	return {
+		.path = path,
+		.size = (uint64_t)st.st_size,
+		.mtime = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec,
+	};
+}
+
+// On-disk layout of configuration cache: header, included files with their
+// size and modification time, and the parsed tree, where every node is a
+// type byte followed by its contents; strings and counts are prefixed with
+// their 32 bit length. Bump version whenever the layout or the parser's
+// output changes.
+struct CONFIG_CACHE_HEADER {
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t hash;		// FNV-1a of configuration file
+	uint64_t size;		// size of configuration file
+};
+
+static constexpr char CONFIG_CACHE_MAGIC[8] = { 'L', 'C', 'D', '2', 'C', 'F', 'G', 0 };
+static constexpr uint32_t CONFIG_CACHE_VERSION = 2;
+
+enum CONFIG_CACHE_NODE : unsigned char { CACHE_STRING = 0, CACHE_VECTOR = 1, CACHE_MAP = 2 };
+
+static void cache_put(std::string& out, const std::string& s) {
+
+	uint32_t len = s.size();
+	out.append((const char*)&len, sizeof(len));
+	out.append(s);
+}
+
+static void cache_put(std::string& out, const CONFIG::NODE& node);
+
+static void cache_put(std::string& out, const CONFIG::MAP& m) {
+
+	uint32_t count = m.size();
+
+	out.push_back(CACHE_MAP);
+	out.append((const char*)&count, sizeof(count));
+
+	for ( const auto& [k, v] : m ) {
+		cache_put(out, k);
+		cache_put(out, v);
+	}
+}
+
+static void cache_put(std::string& out, const CONFIG::NODE& node) {
+
+	if ( std::holds_alternative<std::string>(node)) {
+
+		out.push_back(CACHE_STRING);
+		cache_put(out, std::get<std::string>(node));
+
+	} else if ( std::holds_alternative<CONFIG::VECTOR>(node)) {
+
+		const CONFIG::VECTOR& v = std::get<CONFIG::VECTOR>(node);
+		uint32_t count = v.size();
+
+		out.push_back(CACHE_VECTOR);
+		out.append((const char*)&count, sizeof(count));
+
+		for ( const std::string& s : v )
+			cache_put(out, s);
+
+	} else cache_put(out, std::get<CONFIG::MAP>(node));
+}
+
+// Reads nodes back from a mapped cache file, throwing if it is cut short
+struct CONFIG_CACHE_READER {
+
+	const unsigned char *pos;
+	const unsigned char *end;
+
+	void read(void *dst, size_t len) {
+
+		if ( (size_t)( this -> end - this -> pos ) < len )
+			throw std::runtime_error("configuration cache is truncated");
+
+		std::memcpy(dst, this -> pos, len);
+		this -> pos += len;
+	}
+
+	uint32_t count() {
+
+		uint32_t n;
+		this -> read(&n, sizeof(n));
+		return n;
+	}
+
+	std::string string() {
+
+		uint32_t len = this -> count();
+
+		if ( (size_t)( this -> end - this -> pos ) < len )
+			throw std::runtime_error("configuration cache is truncated");
+
+		std::string s((const char*)this -> pos, len);
+		this -> pos += len;
+		return s;
+	}
+
+	void node(CONFIG::NODE& out) {
+
+		unsigned char type;
+		this -> read(&type, 1);
+
+		if ( type == CACHE_STRING )
+			out = this -> string();
+		else if ( type == CACHE_VECTOR ) {
+
+			CONFIG::VECTOR v;
+			for ( uint32_t n = this -> count(); n > 0; n-- )
+				v.push_back(this -> string());
+			out = std::move(v);
+
+		} else if ( type == CACHE_MAP ) {
+
+			out = CONFIG::MAP();
+			CONFIG::MAP& m = std::get<CONFIG::MAP>(out);
+
+			for ( uint32_t n = this -> count(); n > 0; n-- ) {
+				std::string key = this -> string();
+				this -> node(m[key]);
+			}
+
+		} else throw std::runtime_error("configuration cache has unknown node type " + std::to_string(type));
+	}
+};
+
+bool CONFIG::load_cache(uint64_t hash, uint64_t size) {
+
+	int fd = ::open(this -> _cache.c_str(), O_RDONLY | O_CLOEXEC);
+
+	if ( fd < 0 )
+		return false;
+
+	struct stat st;
+
+	if ( fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CONFIG_CACHE_HEADER)) {
+		::close(fd);
+		return false;
+	}
+
+	size_t len = st.st_size;
+	void *map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+
+	if ( map == MAP_FAILED )
+		return false;
+
+	const unsigned char *data = (const unsigned char*)map;
+	CONFIG_CACHE_HEADER hdr;
+	std::memcpy(&hdr, data, sizeof(hdr));
+
+	bool loaded = false;
+
+	if ( std::memcmp(hdr.magic, CONFIG_CACHE_MAGIC, sizeof(CONFIG_CACHE_MAGIC)) == 0 &&
+		hdr.version == CONFIG_CACHE_VERSION && hdr.hash == hash && hdr.size == size ) {
+
+		CONFIG_CACHE_READER reader = { .pos = data + sizeof(hdr), .end = data + len };
+		NODE root;
+
+		try {
+			std::vector<INCLUDE> includes;
+
+			for ( uint32_t n = reader.count(); n > 0; n-- ) {
+
+				INCLUDE inc;
+				inc.path = reader.string();
+				reader.read(&inc.size, sizeof(inc.size));
+				reader.read(&inc.mtime, sizeof(inc.mtime));
+				includes.push_back(std::move(inc));
+			}
+
+			for ( const INCLUDE& inc : includes ) {
+
+				if ( INCLUDE::stat(inc.path) != inc ) {
+
+					logger::verbose["config"] << "configuration cache " << this -> _cache << " is stale, included file " <<
+						inc.path << " has changed" << std::endl;
+					munmap(map, len);
+					return false;
+				}
+			}
+
+			reader.node(root);
+
+			if ( !std::holds_alternative<MAP>(root) || reader.pos != reader.end )
+				throw std::runtime_error("configuration cache has trailing data");
+
+			this -> _cfg = std::move(std::get<MAP>(root));
+			this -> _includes = std::move(includes);
+			loaded = true;
+
+			logger::verbose["config"] << "loaded parsed configuration from cache " << this -> _cache << std::endl;
+
+		} catch ( const std::runtime_error& e ) {
+			logger::warning["config"] << "ignoring configuration cache " << this -> _cache << ": " << e.what() << std::endl;
+		}
+
+	} else logger::verbose["config"] << "configuration cache " << this -> _cache << " is stale" << std::endl;
+
+	munmap(map, len);
+	return loaded;
+}
+
+void CONFIG::save_cache(uint64_t hash, uint64_t size) {
+
+	std::string tmpname = this -> _cache + ".tmp";
+	std::string body;
+
+	CONFIG_CACHE_HEADER hdr;
+	std::memcpy(hdr.magic, CONFIG_CACHE_MAGIC, sizeof(CONFIG_CACHE_MAGIC));
+	hdr.version = CONFIG_CACHE_VERSION;
+	hdr.reserved = 0;
+	hdr.hash = hash;
+	hdr.size = size;
+
+	uint32_t count = this -> _includes.size();
+	body.append((const char*)&count, sizeof(count));
+
+	for ( const INCLUDE& inc : this -> _includes ) {
+		cache_put(body, inc.path);
+		body.append((const char*)&inc.size, sizeof(inc.size));
+		body.append((const char*)&inc.mtime, sizeof(inc.mtime));
+	}
+
+	cache_put(body, this -> _cfg);
+
+	int fd = ::open(tmpname.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+	if ( fd < 0 ) {
+		logger::warning["config"] << "failed to write configuration cache " << tmpname << ": " << std::strerror(errno) << std::endl;
+		return;
+	}
+
+	bool ok = ::write(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr) &&
+		::write(fd, body.data(), body.size()) == (ssize_t)body.size();
+
+	::close(fd);
+
+	if ( !ok || ::rename(tmpname.c_str(), this -> _cache.c_str()) != 0 ) {
+		logger::warning["config"] << "failed to write configuration cache " << this -> _cache << ": " << std::strerror(errno) << std::endl;
+		::unlink(tmpname.c_str());
+		return;
+	}
+
+	logger::verbose["config"] << "wrote parsed configuration to cache " << this -> _cache << std::endl;
+}
+
 std::ostream& operator <<(std::ostream& os, CONFIG const& c) {
 
 	os << dump_cfg(c._cfg, 0);
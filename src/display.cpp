@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <chrono>
 #include <thread>
+#include <filesystem>
+#include <set>
 
 #include "common.hpp"
 #include "logger.hpp"
@@ -12,11 +14,15 @@
 #include "driver.hpp"
 #include "drivers/dpf.hpp"
 #include "drivers/drm.hpp"
+#include "drivers/null.hpp"
 
 #include "rgb.hpp"
+#include "fs_funcs.hpp"
+#include "image_cache.hpp"
 #include "plugin.hpp"
 #include "expr/expression.hpp"
 #include "throws.hpp"
+#include "tick.hpp"
 #include "display.hpp"
 
 DISPLAY *display = nullptr;
@@ -32,11 +38,19 @@ DISPLAY::DISPLAY(CONFIG *cfg) {
 		{ "orientation", "0" },
 		{ "backlight", "5" },
 		{ "backlight_path", "'auto'" },
+		{ "image_cache", "''" },
+		{ "width", "320" },
+		{ "height", "240" },
+		{ "bpp", "4" },
+		{ "warm_pages", "2" },
 	};
 
 	this -> _clean_up = true;
 	this -> _orientation = ORIENTATION::rotate0();
 	this -> _backlight = 5;
+	this -> _config_file = cfg -> _filename;
+	this -> _config_cache = cfg -> _cache;
+	this -> _config = cfg -> _cfg;
 
 	if ( cfg -> _cfg.contains("variables") && std::holds_alternative<CONFIG::MAP>(cfg -> _cfg["variables"]))
 		this -> init_variables(&(std::get<CONFIG::MAP>(cfg -> _cfg["variables"])));
@@ -110,6 +124,13 @@ DISPLAY::DISPLAY(CONFIG *cfg) {
 
 	this -> _backlight = _backlight;
 
+	if ( std::string _cache_dir = this -> P2S("image_cache"); !_cache_dir.empty()) {
+
+		if ( !fs::exists(_cache_dir) || !std::filesystem::is_directory(_cache_dir))
+			logger::error["display"] << "image_cache '" << _cache_dir << "' is not a directory, decoded images are not persisted" << std::endl;
+		else IMAGE_CACHE::directory(_cache_dir);
+	}
+
 	// Everything below allocates owning resources (driver, plugins, widgets,
 	// actions, layout, scheduler) and can still throw via throws<< on a bad
 	// config. If construction fails after a partial allocation, ~DISPLAY never
@@ -128,8 +149,12 @@ DISPLAY::DISPLAY(CONFIG *cfg) {
 		if ( this -> driver == nullptr )
 			throws << "driver initialization failed, reason: unknown" << std::endl;
 
+		// file-watch service shared by plugins and widgets
+		this -> watcher = new WATCHER;
+
 		// add plugins
 		this -> plugins = new plugin;
+		this -> init_plugins(&cfg -> _cfg);
 
 		// add timers
 		this -> init_timers(&cfg -> _cfg);
@@ -155,12 +180,18 @@ DISPLAY::DISPLAY(CONFIG *cfg) {
 		delete this -> widgets;   this -> widgets = nullptr;
 		delete this -> plugins;   this -> plugins = nullptr;
 		delete this -> driver;    this -> driver = nullptr;
+		delete this -> watcher;   this -> watcher = nullptr;
 		throw;
 	}
 }
 
 DISPLAY::~DISPLAY() {
 
+	if ( this -> watcher != nullptr ) {
+		delete this -> watcher;
+		this -> watcher = nullptr;
+	}
+
 	if ( this -> driver != nullptr ) {
 
 		try {
@@ -220,7 +251,12 @@ ORIENTATION DISPLAY::orientation() {
 }
 
 void DISPLAY::orientation(ORIENTATION orientation) {
+
 	this -> _orientation = orientation;
+
+	// surfaces are in panel orientation, start over
+	if ( this -> layout != nullptr && !this -> canvas.empty())
+		this -> init_canvas();
 }
 
 int DISPLAY::backlight() {
@@ -283,55 +319,152 @@ void DISPLAY::refresh() {
 	this -> driver -> refresh();
 }
 
-void DISPLAY::add_pixel(int x, int y, int page, int layer, RGBA color) {
+// Panel coordinates of display pixel x,y
+static RECT::POINT to_panel(ORIENTATION orientation, int pw, int ph, int x, int y) {
+
+	if ( orientation.isRotated90())
+		return { .x = y, .y = ph - 1 - x };
+	else if ( orientation.isRotated180())
+		return { .x = pw - 1 - x, .y = ph - 1 - y };
+	else if ( orientation.isRotated270())
+		return { .x = pw - 1 - y, .y = x };
+
+	return { .x = x, .y = y };
+}
+
+// Block size, in pixels, of the transposing copy used for 90 and 270 degree
+// rotation; 16 RGBA pixels of a row are a single cache line.
+static constexpr int TILE = 16;
+
+// Copies clip area (in bitmap coordinates) of bitmap to surface pixels where
+// bitmap pixel x,y lands on index offset + x * step_x + y * step_y.
+// Specialised per rotation so that inner loops have a fixed direction: 0 and
+// 180 degrees copy whole rows, 90 and 270 turn bitmap rows into surface
+// columns and copy in TILE x TILE blocks, writing contiguous runs while the
+// strided bitmap reads stay in cache.
+template<unsigned int ROTATION>
+static void copy_rect(RGBA *pixels, int offset, int step_x, int step_y, const RECT& clip, int width, const RGBA *bitmap) {
+
+	int x0 = clip.min.x, x1 = clip.max.x;
+	int y0 = clip.min.y, y1 = clip.max.y;
+
+	if constexpr ( ROTATION == 0 || ROTATION == 2 ) {
+
+		int n = x1 - x0;
 
-	int _x = x;
-	int _y = y;
+		for ( int y = y0; y < y1; y++ ) {
+
+			RGBA *dst = pixels + offset + y * step_y + x0 * step_x;
+
+			if constexpr ( ROTATION == 0 )
+				std::copy_n(bitmap + ( y * width ) + x0, n, dst);
+			else std::reverse_copy(bitmap + ( y * width ) + x0, bitmap + ( y * width ) + x1, dst - ( n - 1 ));
+		}
+
+	} else {
+
+		for ( int ty = y0; ty < y1; ty += TILE ) {
+
+			int ey = ty + TILE < y1 ? ty + TILE : y1;
+
+			for ( int tx = x0; tx < x1; tx += TILE ) {
+
+				int ex = tx + TILE < x1 ? tx + TILE : x1;
+
+				for ( int x = tx; x < ex; x++ ) {
+
+					RGBA *dst = pixels + offset + x * step_x + ty * step_y;
+					const RGBA *src = bitmap + ( ty * width ) + x;
+
+					for ( int y = ty; y < ey; y++, dst += step_y, src += width )
+						*dst = *src;
+				}
+			}
+		}
+	}
+}
+
+void DISPLAY::place(CANVAS::PLACEMENT& placement, const RECT& rect) {
+
+	int width = rect.max.x - rect.min.x;
+	int height = rect.max.y - rect.min.y;
+
+	placement = CANVAS::PLACEMENT();
+	placement.rect = rect;
+	placement.placed = true;
+
+	// visible part of rect, in bitmap coordinates
+	placement.clip = RECT(rect.min.x < 0 ? -rect.min.x : 0, rect.min.y < 0 ? -rect.min.y : 0,
+		std::min(width, this -> width() - rect.min.x), std::min(height, this -> height() - rect.min.y));
+
+	const RECT& clip = placement.clip;
+
+	placement.inside = width <= 0 || height <= 0 ||
+		( clip.min.x == 0 && clip.min.y == 0 && clip.max.x == width && clip.max.y == height );
+
+	if ( width <= 0 || height <= 0 || clip.max.x <= clip.min.x || clip.max.y <= clip.min.y )
+		return;
+
+	// surface covers visible part of rect on panel
+	int pw = this -> _width, ph = this -> _height;
+	RECT::POINT a = to_panel(this -> _orientation, pw, ph, rect.min.x + clip.min.x, rect.min.y + clip.min.y);
+	RECT::POINT b = to_panel(this -> _orientation, pw, ph, rect.min.x + clip.max.x - 1, rect.min.y + clip.max.y - 1);
+
+	placement.panel = RECT(std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.x, b.x) + 1, std::max(a.y, b.y) + 1);
+
+	int sw = placement.panel.max.x - placement.panel.min.x;
+
+	// surface index of bitmap pixel 0,0 and index increments per bitmap x and y
+	RECT::POINT o = to_panel(this -> _orientation, pw, ph, rect.min.x, rect.min.y);
+	placement.offset = ( o.y - placement.panel.min.y ) * sw + ( o.x - placement.panel.min.x );
+	placement.step_x = 1;
+	placement.step_y = sw;
 
 	if ( this -> _orientation.isRotated90()) {
-		_x = y;
-		_y = this -> width() - 1 - x;
+		placement.step_x = -sw;
+		placement.step_y = 1;
 	} else if ( this -> _orientation.isRotated180()) {
-		_x = this -> width() - 1 - x;
-		_y = this -> height() - 1 - y;
+		placement.step_x = -1;
+		placement.step_y = -sw;
 	} else if ( this -> _orientation.isRotated270()) {
-		_x = this -> height() - 1 - y;
-		_y = x;
+		placement.step_x = sw;
+		placement.step_y = -1;
 	}
+}
 
-	if ( _x < 0 || _x >= this -> _width || _y < 0 || _y >= this -> _height ) {
+bool DISPLAY::blit(CANVAS::SURFACE& surface, const CANVAS::PLACEMENT& placement, const RGBA *bitmap) {
 
-		logger::warning["draw"] << "add_pixel: x/y out of bounds" <<
-                        logger::detail("(x=" + std::to_string(x) + "->" + std::to_string(_x) +
-                                        ", y=" + std::to_string(y) + "->" + std::to_string(_y) +
-                                        ", rot=" + std::to_string(this -> _orientation.angle()) +
-                                        ", width=" + std::to_string(this -> pwidth()) + "->" + std::to_string(this -> width()) +
-                                        ", height=" + std::to_string(this -> pheight()) + "->" + std::to_string(this -> height()) +
-					")") << std::endl;
-		return;
+	const RECT& clip = placement.clip;
+	int width = placement.rect.max.x - placement.rect.min.x;
+
+	if ( bitmap == nullptr || placement.panel.max.x <= placement.panel.min.x || placement.panel.max.y <= placement.panel.min.y ) {
+
+		surface.rect = RECT();
+		surface.pixels.clear();
+		return placement.inside;
 	}
 
-	if ( !this -> canvas.contains(page))
-		throws << "add_pixel: error while adding pixel, " << LAYOUT::page_name(page) << " is not initialized" << std::endl;
+	surface.rect = placement.panel;
+	surface.pixels.resize(( surface.rect.max.x - surface.rect.min.x ) * ( surface.rect.max.y - surface.rect.min.y ));
 
-	if ( !this -> canvas[page].contains(layer))
-		throws << "add_pixel: error while adding pixel, " << LAYOUT::page_name(page) <<
-			" does not have layer " << layer << " initialized" << std::endl;
+	int offset = placement.offset, step_x = placement.step_x, step_y = placement.step_y;
 
-	if ( this -> canvas[page][layer].size() < (size_t)(( _y * this -> pwidth()) + _x + 1 ))
-		throws << "add_pixel: pixel coordinates out of canvas bounds" << std::endl;
+	switch ( this -> _orientation.value()) {
+		case 1: copy_rect<1>(surface.pixels.data(), offset, step_x, step_y, clip, width, bitmap); break;
+		case 2: copy_rect<2>(surface.pixels.data(), offset, step_x, step_y, clip, width, bitmap); break;
+		case 3: copy_rect<3>(surface.pixels.data(), offset, step_x, step_y, clip, width, bitmap); break;
+		default: copy_rect<0>(surface.pixels.data(), offset, step_x, step_y, clip, width, bitmap);
+	}
 
-	this -> canvas[page][layer][(_y * this -> pwidth()) + _x] = color;
+	return placement.inside;
 }
 
-std::vector<RGBA> DISPLAY::new_layer() {
-
-	std::vector<RGBA> layer;
+bool DISPLAY::blit(CANVAS::SURFACE& surface, const RECT& rect, const RGBA *bitmap) {
 
-	for ( int i = 0; i < this -> _width * this -> _height; i++ )
-		layer.push_back(RGBA(RGBA::NO));
+	CANVAS::PLACEMENT placement;
 
-	return layer;
+	this -> place(placement, rect);
+	return this -> blit(surface, placement, bitmap);
 }
 
 void DISPLAY::init_variables(CONFIG::MAP *cfg) {
@@ -441,7 +574,8 @@ void DISPLAY::init_variables(CONFIG::MAP *cfg) {
 void DISPLAY::init_display(CONFIG::MAP *cfg) {
 
 	std::vector<std::string> allowed_keys = {
-		"driver", "device", "foreground", "background", "basecolor", "orientation", "backlight", "backlight_path"
+		"driver", "device", "foreground", "background", "basecolor", "orientation", "backlight", "backlight_path",
+		"image_cache", "width", "height", "bpp", "warm_pages"
 	};
 
 	for ( auto& [k, v] : *cfg ) {
@@ -477,10 +611,10 @@ void DISPLAY::init_display(CONFIG::MAP *cfg) {
 
 			this -> _properties[key] = "'" + common::unquoted(value) + "'";
 
-		} else if ( key == "backlight_path" ) {
+		} else if ( key == "backlight_path" || key == "image_cache" ) {
 
 			if ( !CONFIG::evaluate_string("display", key, value, value, false)) {
-				logger::warning["config"] << "failure with backlight_path in display section" << std::endl;
+				logger::warning["config"] << "failure with " << key << " in display section" << std::endl;
 				continue;
 			}
 
@@ -529,12 +663,65 @@ void DISPLAY::init_display(CONFIG::MAP *cfg) {
 
 			this -> _properties[key] = value;
 
+		} else if ( key == "width" || key == "height" || key == "bpp" || key == "warm_pages" ) {
+
+			int i;
+
+			if ( !CONFIG::evaluate_int("display", key, value, i)) {
+
+				logger::warning["config"] << "failure with " << key << " in display section, value did not" <<
+					" evaluate as number" << std::endl;
+				continue;
+			}
+
+			if ( key == "bpp" && i != 2 && i != 3 && i != 4 ) {
+
+				logger::warning["config"] << "failure with " << key << " in display section, value " << i <<
+					" is not one of 2, 3 or 4" << std::endl;
+				continue;
+			} else if ( key == "warm_pages" && ( i < 1 || i > 64 )) {
+
+				logger::warning["config"] << "failure with " << key << " in display section, value " << i <<
+					" not in allowed range between 1 and 64" << std::endl;
+				continue;
+			} else if ( key != "bpp" && key != "warm_pages" && ( i < 1 || i > 8192 )) {
+
+				logger::warning["config"] << "failure with " << key << " in display section, value " << i <<
+					" not in allowed range between 1 and 8192" << std::endl;
+				continue;
+			}
+
+			this -> _properties[key] = value;
+
 		}
 
 	}
 
 }
 
+void DISPLAY::init_plugins(CONFIG::MAP *cfg) {
+
+	for ( auto& [k, v] : *cfg ) {
+
+		std::string key = common::unquoted(common::to_lower(common::trim_ws(std::as_const(k))));
+
+		if ( !key.starts_with("plugin:"))
+			continue;
+
+		key.erase(0, 7);
+
+		if ( !std::holds_alternative<CONFIG::MAP>((*cfg)[k])) {
+
+			logger::error["config"] << "failed to configure plugin " << ( key.empty() ? "" : ( key + " " )) <<
+				", configuration for plugin is not object" << std::endl;
+			continue;
+		}
+
+		logger::debug["config"] << "configuring plugin: '" << key << "'" << std::endl;
+		this -> plugins -> add(key, &std::get<CONFIG::MAP>((*cfg)[k]));
+	}
+}
+
 void DISPLAY::init_timers(CONFIG::MAP *cfg) {
 
 	if ( this -> actions == nullptr )
@@ -674,34 +861,57 @@ void DISPLAY::init_driver(const std::string& name, const std::string& device) {
                         throws << "fatal error, reason: " << e.what() << std::endl;
                 }
 
+        } else if ( _name == "null" ) {
+
+                try {
+                        this -> _width = this -> P2I("width", 320);
+                        this -> _height = this -> P2I("height", 240);
+                        driver = new drv::NUL(common::unquoted(device), this -> _backlight, this -> P2I("bpp", 4), this -> _width, this -> _height);
+                } catch ( std::runtime_error &e ) {
+                        driver = nullptr;
+                        throws << "fatal error, reason: " << e.what() << std::endl;
+                }
+
         } else throws << "Unsupported device driver '" << _name << "'" << std::endl;
 
 	if ( this -> driver == nullptr )
 		throws << "fatal error, driver " << name << " was not initialized" << std::endl;
 }
 
-void DISPLAY::init_canvas() {
+// With keep, canvas is left as it is if the compiled layout still has the same
+// surfaces; widgets were re-created but placements did not change.
+void DISPLAY::init_canvas(bool keep) {
 
 	if ( this -> layout != nullptr ) {
 
 		logger::debug["layout"] << "initializing canvas" << std::endl;
 
-		if ( !this -> canvas.empty()) {
+		this -> layout -> compile();
 
-			logger::debug["layout"] << "canvas already initialized, re-initializing" << std::endl;
-			this -> canvas.clear();
-		}
+		// one surface for every widget placement, allocated when page is first used
+		std::map<int, size_t> surfaces;
 
-		for ( const auto& page : this -> layout -> pages ) {
-			for ( const auto& layer : page.second.layers ) {
+		for ( const auto& [page_no, draws] : this -> layout -> compiled ) {
 
-				logger::debug["layout"] << "adding layer " << layer.second.number << " to " <<
-					LAYOUT::page_name(page.second.number) << " on canvas" << std::endl;
+			logger::debug["layout"] << "adding " << draws.size() << " surfaces of " <<
+				LAYOUT::page_name(page_no) << " on canvas" << std::endl;
 
-				this -> canvas[page.second.number][layer.second.number] = this -> new_layer();
-			}
+			surfaces[page_no] = draws.size();
 		}
 
+		if ( keep && this -> canvas.fits(surfaces)) {
+
+			logger::debug["layout"] << "surfaces did not change, keeping canvas" << std::endl;
+			return;
+		}
+
+		if ( !this -> canvas.empty())
+			logger::debug["layout"] << "canvas already initialized, re-initializing" << std::endl;
+
+		this -> canvas.init(this -> _width, this -> _height, surfaces, this -> P2I("warm_pages", 2));
+
+		logger::verbose["layout"] << "canvas keeps " << this -> canvas.warm() << " pages warm in addition to active page" << std::endl;
+
 	} else throws << "failure to initialize canvas, layout not initialized" << std::endl;
 }
 
@@ -716,6 +926,8 @@ void DISPLAY::init_scheduler(CONFIG::MAP *cfg) {
 	}
 
 	bool is_threaded = true;
+	std::string metrics;
+	int metrics_interval = 10000;
 
 	if ( cfg != nullptr ) {
 		for ( auto& [k, v] : *cfg ) {
@@ -748,6 +960,24 @@ void DISPLAY::init_scheduler(CONFIG::MAP *cfg) {
 					is_threaded = false;
 
 				continue;
+
+			} else if ( key == "metrics" || key == "metrics_interval" ) {
+
+				if ( !std::holds_alternative<std::string>(v)) {
+
+					logger::error["config"] << "invalid scheduler config, option " << key << " must be a single value" << std::endl;
+					continue;
+				}
+
+				std::string value = std::get<std::string>(v);
+
+				if ( key == "metrics" && !CONFIG::evaluate_string("scheduler", key, value, metrics, false))
+					logger::error["config"] << "invalid scheduler config, failed to evaluate " << key << std::endl;
+				else if ( key == "metrics_interval" && !CONFIG::evaluate_int("scheduler", key, value, metrics_interval))
+					logger::error["config"] << "invalid scheduler config, " << key << " did not evaluate as number" << std::endl;
+
+				continue;
+
 			} else if ( key.empty()) continue;
 
 			logger::error["config"] << "invalid scheduler configuration, unsupported option " << key << std::endl;
@@ -757,6 +987,9 @@ void DISPLAY::init_scheduler(CONFIG::MAP *cfg) {
 	logger::debug["scheduler"] << ( is_threaded ? "enabling" : "disabling" ) << " threading" << std::endl;
 
 	this -> scheduler = new SCHEDULER(this, is_threaded);
+
+	if ( metrics = common::unquoted(metrics); !metrics.empty())
+		this -> scheduler -> metrics.listen(metrics, metrics_interval);
 }
 
 // One-shot deferred initialisation: resolves widget references in the layout,
@@ -798,8 +1031,7 @@ void DISPLAY::clean_up() {
 	}
 
 	for ( const auto& timer : this -> timers )
-		this -> timers[timer.first].last_updated =
-			std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+		this -> timers[timer.first].last_updated = TICK::millis();
 
 	for ( const auto& page : this -> layout -> pages ) {
 
@@ -895,21 +1127,31 @@ bool DISPLAY::setpage(int page_no) {
 
 	if ( page_no != -1 && this -> scheduler -> exit_loop()) return true;
 
-	this -> layout -> pages[this -> _page].update_widgets();
+	// page rendered ahead by scheduler only needs to be shown, unless
+	// on_enter timer just ran and might have changed its content
+	if ( !this -> scheduler -> claim_prerendered(this -> _page) || !this -> canvas.allocated(this -> _page) ||
+		!this -> layout -> pages[this -> _page].on_enter.empty()) {
 
-	if ( page_no != -1 && this -> scheduler -> exit_loop()) return true;
+		this -> layout -> pages[this -> _page].update_widgets();
 
-	int render_page = this -> _page;
-	this -> layout -> render(&render_page);
+		if ( page_no != -1 && this -> scheduler -> exit_loop()) return true;
+
+		int render_page = this -> _page;
+		this -> layout -> render(&render_page);
+	} else logger::debug["display"] << "showing prerendered " << LAYOUT::page_name(this -> _page) << std::endl;
 
 	if ( page_no != -1 && this -> scheduler -> exit_loop()) return true;
 
+	if ( page_no != -1 )
+		this -> _transition.run(current_page, this -> _page, this -> layout -> transition_to(this -> _page));
+
 	this -> refresh();
 	return true;
 }
 
 bool DISPLAY::goodbye() {
 
+	TICK::SCOPE tick;
 	int page_no = -1;
 
 	if ( !this -> setpage(page_no))
@@ -931,6 +1173,16 @@ bool DISPLAY::threading() {
 	return this -> scheduler == nullptr ? false : this -> scheduler -> threading();
 }
 
+void DISPLAY::prepare() {
+
+	this -> clean_up();
+
+	if ( this -> canvas.empty())
+		this -> init_canvas();
+
+	this -> clear();
+}
+
 void DISPLAY::run() {
 
 	this -> clean_up();
@@ -940,6 +1192,295 @@ void DISPLAY::run() {
 	else throws << "fatal error, scheduler is not ready" << std::endl;
 }
 
+using SECTIONS = std::map<std::string, CONFIG::NODE*>;
+
+static std::string section_name(const std::string& key) {
+
+	std::string name = key;
+	return common::unquoted(common::to_lower(common::trim_ws(std::as_const(name))));
+}
+
+// Top level sections of configuration by their normalized names
+static SECTIONS sections(CONFIG::MAP& cfg) {
+
+	SECTIONS result;
+
+	for ( auto& [k, v] : cfg )
+		result[section_name(k)] = &cfg[k];
+
+	return result;
+}
+
+// Replaces section name of cfg with the one of from, or removes it when from does not have it
+static void keep_section(CONFIG::MAP& cfg, const CONFIG::MAP& from, const std::string& name) {
+
+	std::vector<std::string> keys;
+
+	for ( const auto& [k, v] : cfg )
+		if ( section_name(k) == name )
+			keys.push_back(k);
+
+	for ( const std::string& k : keys )
+		cfg.erase(k);
+
+	for ( const auto& [k, v] : from )
+		if ( section_name(k) == name )
+			cfg[k] = v;
+}
+
+static CONFIG::MAP* section(const SECTIONS& s, const std::string& name) {
+
+	auto it = s.find(name);
+	return it == s.end() || !std::holds_alternative<CONFIG::MAP>(*it -> second) ? nullptr : &std::get<CONFIG::MAP>(*it -> second);
+}
+
+// Keys that were added, removed or changed between two sections
+static std::set<std::string> changed_keys(const CONFIG::MAP *before, const CONFIG::MAP *after) {
+
+	std::set<std::string> keys;
+
+	if ( before != nullptr )
+		for ( const auto& [k, v] : *before )
+			if ( after == nullptr || !after -> contains(k) || !CONFIG::same(v, after -> at(k)))
+				keys.insert(k);
+
+	if ( after != nullptr )
+		for ( const auto& [k, v] : *after )
+			if ( before == nullptr || !before -> contains(k))
+				keys.insert(k);
+
+	return keys;
+}
+
+// Sections are compared as a whole; a changed section is re-created from
+// scratch, everything else stays as it is. Sections referring to a changed
+// variable count as changed. Changes that need the driver opened again are
+// only reported.
+bool DISPLAY::reload() {
+
+	CONFIG::MAP next;
+
+	try {
+		CONFIG cfg(this -> _config_file, this -> _config_cache);
+		next = cfg._cfg;
+	} catch ( const std::exception& e ) {
+		logger::error["config"] << "failed to reload configuration, keeping current one, reason: " << e.what() << std::endl;
+		return false;
+	}
+
+	SECTIONS before = sections(this -> _config);
+	SECTIONS after = sections(next);
+	std::set<std::string> changed;
+
+	for ( const auto& [name, node] : after )
+		if ( !before.contains(name) || !CONFIG::same(*before[name], *node))
+			changed.insert(name);
+
+	for ( const auto& [name, node] : before )
+		if ( !after.contains(name))
+			changed.insert(name);
+
+	std::set<std::string> variables = changed.contains("variables") ?
+		changed_keys(section(before, "variables"), section(after, "variables")) : std::set<std::string>();
+
+	for ( const auto& [name, node] : after ) {
+
+		if ( name == "variables" || changed.contains(name))
+			continue;
+
+		for ( const std::string& var : variables ) {
+
+			if ( CONFIG::mentions(*node, var)) {
+				changed.insert(name);
+				break;
+			}
+		}
+	}
+
+	if ( changed.empty()) {
+
+		logger::info["config"] << "configuration reloaded, nothing changed" << std::endl;
+		return false;
+	}
+
+	logger::info["config"] << "configuration reloaded, changed: " <<
+		common::join_vector(std::vector<std::string>(changed.begin(), changed.end())) << std::endl;
+
+	bool all_widgets = false;
+	bool new_canvas = false;
+	bool new_layout = changed.contains("layout");
+
+	if ( changed.contains("variables")) {
+
+		for ( const std::string& var : variables )
+			CONFIG::variables.erase(var);
+
+		if ( CONFIG::MAP *cfg = section(after, "variables"); cfg != nullptr )
+			this -> init_variables(cfg);
+	}
+
+	if ( changed.contains("display")) {
+
+		CONFIG::MAP *cfg = section(after, "display");
+		std::set<std::string> keys = changed_keys(section(before, "display"), cfg);
+		std::vector<std::string> restart;
+
+		// changed only through a variable
+		if ( keys.empty() && cfg != nullptr )
+			for ( const auto& [k, v] : *cfg )
+				keys.insert(k);
+
+		for ( const char *key : { "driver", "device", "width", "height", "bpp", "backlight_path" })
+			if ( keys.contains(key))
+				restart.push_back(key);
+
+		if ( !restart.empty())
+			logger::warning["config"] << "display " << common::join_vector(restart) << " changed, restart lcd2 to apply" << std::endl;
+
+		try {
+			if ( cfg != nullptr )
+				this -> init_display(cfg);
+		} catch ( const std::exception& e ) {
+			logger::error["config"] << e.what() << std::endl;
+		}
+
+		if ( keys.contains("backlight"))
+			this -> backlight(this -> P2I("backlight", this -> _backlight));
+
+		if ( keys.contains("foreground") || keys.contains("background") || keys.contains("basecolor")) {
+
+			RGBA fg = RGBA(this -> P2S("foreground", "ffffff"), true);
+			RGBA bg = RGBA(this -> P2S("background", "000000"), true);
+			RGBA bl = RGBA(this -> P2S("basecolor", "000000"), true);
+
+			RGBA::FG = { .R = fg.R, .G = fg.G, .B = fg.B, .A = fg.A };
+			RGBA::BG = { .R = bg.R, .G = bg.G, .B = bg.B, .A = bg.A };
+			RGBA::BL = { .R = bl.R, .G = bl.G, .B = bl.B, .A = bl.A };
+			all_widgets = true;
+		}
+
+		if ( keys.contains("orientation")) {
+
+			int o = this -> P2I("orientation", 0);
+
+			this -> _orientation = o == 1 ? ORIENTATION::rotate90() : ( o == 2 ? ORIENTATION::rotate180() :
+				( o == 3 ? ORIENTATION::rotate270() : ORIENTATION::rotate0()));
+			all_widgets = true;
+			new_canvas = true;
+		}
+
+		if ( keys.contains("warm_pages"))
+			new_canvas = true;
+
+		if ( std::string dir = this -> P2S("image_cache"); keys.contains("image_cache") &&
+			!dir.empty() && fs::exists(dir) && std::filesystem::is_directory(dir))
+			IMAGE_CACHE::directory(dir);
+	}
+
+	for ( const std::string& name : changed ) {
+
+		if ( !name.starts_with("plugin:"))
+			continue;
+
+		if ( CONFIG::MAP *cfg = section(after, name); cfg != nullptr )
+			this -> plugins -> add(name.substr(7), cfg);
+		else logger::warning["config"] << "section " << name << " was removed, its settings stay until restart" << std::endl;
+	}
+
+	for ( const std::string& name : changed ) {
+
+		if ( !name.starts_with("timer:"))
+			continue;
+
+		std::string key = name.substr(6);
+
+		if ( this -> timers.contains(key))
+			this -> timers.erase(key);
+
+		if ( CONFIG::MAP *cfg = section(after, name); cfg != nullptr && !key.empty()) {
+
+			try {
+				this -> timers[key] = TIMER(key, cfg);
+				this -> timers[key].last_updated = TICK::millis();
+			} catch ( std::exception& e ) {
+				logger::error["config"] << "failed to add timer '" << key << "', reason: " << e.what() << std::endl;
+				if ( this -> timers.contains(key))
+					this -> timers.erase(key);
+			}
+		}
+	}
+
+	bool widgets_changed = false;
+
+	// drawn bitmaps depend on colours and display size, start over
+	if ( all_widgets )
+		for ( const auto& [name, node] : after )
+			if ( name.starts_with("widget:"))
+				changed.insert(name);
+
+	for ( const std::string& name : changed ) {
+
+		if ( !name.starts_with("widget:"))
+			continue;
+
+		std::string key = name.substr(7);
+		bool existed = this -> widgets -> contains(key);
+
+		this -> widgets -> erase(key);
+
+		if ( CONFIG::MAP *cfg = section(after, name); cfg != nullptr )
+			this -> widgets -> add(key, cfg);
+
+		// layout dropped links to widgets that were missing when it was set up
+		if ( existed != this -> widgets -> contains(key))
+			new_layout = true;
+
+		widgets_changed = true;
+	}
+
+	if ( new_layout ) {
+
+		delete this -> layout;
+		this -> layout = nullptr;
+		this -> init_layout(&next);
+
+		if ( this -> layout == nullptr ) {
+
+			logger::error["config"] << "failed to reload layout, restoring previous one" << std::endl;
+			this -> init_layout(&this -> _config);
+
+			if ( this -> layout == nullptr ) {
+
+				logger::error["config"] << "fatal error, failed to restore previous layout, exiting" << std::endl;
+
+				if ( this -> scheduler != nullptr )
+					this -> scheduler -> exit_loop(true);
+
+				return false;
+			}
+
+			// previous layout is what runs, next reload compares against it
+			keep_section(next, this -> _config, "layout");
+		}
+
+		// layout starts over from its first page, as on startup
+		this -> _clean_up = true;
+		this -> clean_up();
+		new_canvas = true;
+	}
+
+	if ( new_canvas )
+		this -> init_canvas();
+	else if ( widgets_changed )
+		this -> init_canvas(true);
+
+	if ( changed.contains("scheduler"))
+		logger::warning["config"] << "scheduler section changed, restart lcd2 to apply" << std::endl;
+
+	this -> _config = std::move(next);
+	return true;
+}
+
 // Serialises the full running config as a human-readable block.
 // NOTE: clean_up() is called here as a side effect so that the dump reflects
 // the pruned layout state (missing widgets removed, empty layers dropped).
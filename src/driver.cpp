@@ -1,5 +1,6 @@
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
 
 #include "throws.hpp"
 #include "logger.hpp"
@@ -8,7 +9,7 @@
 #include "display.hpp"
 #include "driver.hpp"
 
-std::vector<std::string> drv::list({ "dpf", "drm" });
+std::vector<std::string> drv::list({ "dpf", "drm", "null" });
 
 int drv::DRIVER::pwidth() {
 	return this -> _pwidth;
@@ -22,53 +23,27 @@ RGBA drv::DRIVER::rgb(int x, int y) {
 	return this -> blend(x, y);
 }
 
-static std::vector<RGBA>cc;
-
 RGBA drv::DRIVER::blend(int x, int y) {
 
-	// TODO: o = -1 ??? is this ok?
-
-	int o = -1;
-	RGBA ret({ .R = RGBA::BL.R, .G = RGBA::BL.G, .B = RGBA::BL.B, .A = 0x00 });
-
+	RGBA ret;
 	int page_no = display -> page_number();
 
-	if ( !display -> canvas.contains(page_no))
+	if ( !compose(page_no, y, x, x + 1, &ret))
 		throws << "fatal error: page " << page_no << " does not exist on canvas" << std::endl;
 
-	if ( display -> canvas[page_no].empty())
-		throws << "fatal error: page " << page_no << " has no layers" << std::endl;
-
-	for ( auto& [l, v] : display -> canvas[page_no]) {
+	return ret;
+}
 
-		RGBA p = display -> canvas[page_no][l][(y * display -> _width) + x];
+bool drv::DRIVER::compose(int page_no, int y, int x0, int x1, RGBA *out) {
 
-		if ( p.A == 0xff ) {
-			o = l;
-			break;
-		}
-	}
+	// transition in progress, show its frame instead of page
+	if ( display -> _frame != nullptr ) {
 
-	for ( auto& [l, v] : display -> canvas[page_no]) {
-
-		if ( l < o )
-			continue;
-
-		RGBA p = display -> canvas[page_no][l][(y * display -> _width) + x];
-		switch ( p.A ) {
-			case 0: break;
-			case 0xff:
-				ret = RGBA({ .R = p.R, .G = p.G, .B = p.B, .A = 0xff });
-				break;
-			default:
-				unsigned int R = ( p.R * p.A + ret.R * ( 0xff - p.A )) / 0xff;
-				unsigned int G = ( p.G * p.A + ret.G * ( 0xff - p.A )) / 0xff;
-				unsigned int B = ( p.B * p.A + ret.B * ( 0xff - p.A )) / 0xff;
-				ret = RGBA({ .R = (unsigned char)R, .G = (unsigned char)G, .B = (unsigned char)B, .A = 0xff });
-		}
+		std::copy_n(display -> _frame -> data() + y * display -> _width + x0, x1 - x0, out);
+		return true;
 	}
 
-	return ret;
+	return display -> canvas.compose(page_no, y, x0, x1, out);
 }
 
 int drv::DRIVER::backlight() {
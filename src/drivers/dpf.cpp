@@ -8,6 +8,7 @@
 #include "display.hpp"
 #include "orientation.hpp"
 #include "rect.hpp"
+#include "trace.hpp"
 #include "driver.hpp"
 #include "drivers/dpf.hpp"
 
@@ -148,13 +149,41 @@ void drv::DPF::backlight(int value) {
 	this -> ax_backlight(value < 0 ? 0 : ( value > 7 ? 7 : value ));
 }
 
+// Composes pixels x0..x1 of rows y0..y1 of current page into composed, at
+// their places on panel; false if page is not on canvas.
+bool drv::DPF::compose_rows(int y0, int y1, int x0, int x1) {
+
+	int page_no = display -> page_number();
+
+	if ( !display -> canvas.contains(page_no))
+		return false;
+
+	this -> composed.resize(this -> _pwidth * this -> _pheight);
+
+	for ( int y = y0; y < y1; y++ )
+		if ( !compose(page_no, y, x0, x1, this -> composed.data() + y * this -> _pwidth + x0 ))
+			return false;
+
+	return true;
+}
+
 void drv::DPF::blit(int x, int y, int width, int height) {
 
+	TRACE_SPAN("blit");
+
+	int x0 = x < 0 ? 0 : x;
+	int x1 = x + width < this -> _pwidth ? x + width : this -> _pwidth;
+	int y0 = y < 0 ? 0 : y;
+	int y1 = y + height < this -> _pheight ? y + height : this -> _pheight;
+
+	if ( x0 >= x1 || y0 >= y1 || !this -> compose_rows(y0, y1, x0, x1))
+		return;
+
 	this -> rect_reset(this -> bounds);
 
-	for ( int _y = y; _y < y + height; _y++ ) {
-		for ( int _x = x; _x < x + width; _x++ ) {
-			this -> set_pixel(_x, _y, this -> blend(_x, _y));
+	for ( int _y = y0; _y < y1; _y++ ) {
+		for ( int _x = x0; _x < x1; _x++ ) {
+			this -> set_pixel(_x, _y, this -> composed[(_y * this -> _pwidth ) + _x]);
 		}
 	}
 
@@ -177,10 +206,17 @@ void drv::DPF::blit(int x, int y, int width, int height) {
 
 void drv::DPF::blit_fullscreen() {
 
+	TRACE_SPAN("blit_fullscreen");
+
 	int y = 0, _y;
 	RECT rect;
 	std::vector<RECT> rects;
 
+	if ( !this -> compose_rows(0, this -> _pheight, 0, this -> _pwidth))
+		return;
+
+	const std::vector<RGBA>& page = this -> composed;
+
 	// One-shot forced full repaint (startup): write every pixel and send the
 	// whole screen in one transfer, bypassing the dirty-rect delta below, so
 	// the panel is fully painted regardless of its prior/demo content.
@@ -188,9 +224,7 @@ void drv::DPF::blit_fullscreen() {
 
 		this -> _force_full = false;
 
-		for ( int fy = 0; fy < this -> _pheight; fy++ )
-			for ( int fx = 0; fx < this -> _pwidth; fx++ )
-				this -> canvas[(fy * this -> _pwidth) + fx] = this -> blend(fx, fy);
+		std::copy(page.begin(), page.end(), this -> canvas.begin());
 
 		this -> ax_blit(this -> canvas, RECT(0, 0, this -> _pwidth, this -> _pheight));
 		this -> rect_reset(this -> bounds);
@@ -208,7 +242,7 @@ void drv::DPF::blit_fullscreen() {
 		// find first line that has changed
 		for ( _y = y; _y < this -> _pheight && !changed; _y++ ) {
 			for ( int _x = 0; _x < this -> _pwidth && !changed; _x++ ) {
-				if ( auto c = this -> blend(_x, _y); this -> canvas[(_y * this -> _pwidth ) + _x] != c ) {
+				if ( auto c = page[(_y * this -> _pwidth ) + _x]; this -> canvas[(_y * this -> _pwidth ) + _x] != c ) {
 
 					//this -> canvas[(_y * this -> _pwidth ) + _x ] = c;
 					rect.min = RECT::POINT(_x, _y);
@@ -230,7 +264,7 @@ void drv::DPF::blit_fullscreen() {
 
 			for ( int _x = 0; _x < this -> _pwidth; _x++ ) {
 
-				if ( auto c = this -> blend(_x, _y); this -> canvas[(_y * this -> _pwidth ) + _x] != c ) {
+				if ( auto c = page[(_y * this -> _pwidth ) + _x]; this -> canvas[(_y * this -> _pwidth ) + _x] != c ) {
 
 					if ( _x < rect.min.x ) rect.min.x = _x;
 					if ( _x > rect.max.x ) rect.max.x = _x;
@@ -251,7 +285,7 @@ void drv::DPF::blit_fullscreen() {
 
 		for ( _y = rect.min.y; _y <= rect.max.y; _y++ )
 			for ( int _x = rect.min.x; _x <= rect.max.x; _x++ )
-				if ( auto c = this -> blend(_x, _y); this -> canvas[(_y * this -> _pwidth ) + _x] != c )
+				if ( auto c = page[(_y * this -> _pwidth ) + _x]; this -> canvas[(_y * this -> _pwidth ) + _x] != c )
 					this -> canvas[(_y * this -> _pwidth ) + _x ] = c;
 
 		rects.push_back(rect);
@@ -395,11 +429,17 @@ void drv::DPF::ax_blit(std::vector<RGBA>& buf, const RECT& rect) {
 	if ( buf.empty())
 		return;
 
-	std::vector<unsigned char> xferBuf;
-	std::for_each(buf.begin(), buf.end(), [&xferBuf](RGBA c) {
-		std::vector<unsigned char>rgb = c.RGB565();
-		std::copy(rgb.begin(), rgb.end(), std::back_inserter(xferBuf));
-	});
+	TRACE_SPAN("ax_blit");
+
+	// panel takes RGB565 big endian
+	std::vector<uint16_t> rgb(buf.size());
+	std::vector<unsigned char> xferBuf(buf.size() * 2);
+	RGBA::to_RGB565(buf, rgb);
+
+	for ( size_t i = 0; i < rgb.size(); i++ ) {
+		xferBuf[i * 2] = rgb[i] >> 8;
+		xferBuf[i * 2 + 1] = rgb[i] & 0xff;
+	}
 
 	std::vector<unsigned char> cmd(g_excmd);
 	std::vector<unsigned char> args(this -> rect_args(rect));
@@ -2,6 +2,7 @@
 #include <stdexcept>
 #include <fstream>
 #include <filesystem>
+#include <span>
 
 #include <fcntl.h>
 #include <unistd.h>
@@ -18,6 +19,7 @@
 #include "config.hpp"
 #include "display.hpp"
 #include "rgb.hpp"
+#include "trace.hpp"
 #include "driver.hpp"
 #include "drivers/drm.hpp"
 
@@ -270,15 +272,41 @@ void drv::DRM::write_pixel(int x, int y, const RGBA& c) {
     if (!_buffer.map || x < 0 || x >= _pwidth || y < 0 || y >= _pheight)
         return;
 
-    uint8_t* p = _buffer.map + static_cast<ptrdiff_t>(y) * _buffer.stride + x * 4;
-    p[0] = c.B;
-    p[1] = c.G;
-    p[2] = c.R;
-    p[3] = 0; // unused (XRGB8888)
+    uint32_t v = c.XRGB8888();
+    std::memcpy(_buffer.map + static_cast<ptrdiff_t>(y) * _buffer.stride + x * 4, &v, 4);
+}
+
+// Composes pixels x0..x1 of row y and writes the part that differs from canvas,
+// or all of it when forced, to canvas and framebuffer in bulk.
+bool drv::DRM::blit_row(int page_no, int y, int x0, int x1, bool force) {
+
+    size_t n = x1 - x0;
+    _row.resize(n);
+
+    if (!compose(page_no, y, x0, x1, _row.data()))
+        return false;
+
+    std::span<RGBA> current(this->canvas.data() + y * _pwidth + x0, n);
+    size_t first = force ? 0 : RGBA::mismatch(_row, current);
+
+    if (first == n)
+        return false;
+
+    size_t last = n;
+    while (!force && last > first && _row[last - 1] == current[last - 1])
+        last--;
+
+    std::copy(_row.begin() + first, _row.begin() + last, current.begin() + first);
+
+    uint32_t* fb = reinterpret_cast<uint32_t*>(_buffer.map + static_cast<ptrdiff_t>(y) * _buffer.stride) + x0;
+    RGBA::to_XRGB8888(std::span<const RGBA>(_row).subspan(first, last - first), std::span<uint32_t>(fb + first, last - first));
+    return true;
 }
 
 void drv::DRM::mark_dirty() {
 
+    TRACE_SPAN("mark_dirty");
+
     // Notify the kernel driver that framebuffer content has changed.
     // Required for USB-attached DRM displays (ax206, UDL, etc.) that don't
     // scan the dumb-buffer automatically — they need an explicit upload trigger.
@@ -291,71 +319,21 @@ void drv::DRM::mark_dirty() {
     drmModeDirtyFB(_fd, _buffer.fb_id, &clip, 1);
 }
 
-// Collect layer vectors for the current page once, avoiding per-pixel map lookups.
-// Returns false if the page has no renderable layers.
-static bool collect_layers(int page_no,
-    std::vector<std::pair<int, const std::vector<RGBA>*>>& out)
-{
-    auto pit = display->canvas.find(page_no);
-    if (pit == display->canvas.end() || pit->second.empty())
-        return false;
-    out.clear();
-    for (auto& [l, v] : pit->second)
-        out.emplace_back(l, &v);
-    return true;
-}
-
-// Blend pixel at canvas index idx using pre-collected layer references.
-static RGBA blend_pixel(
-    const std::vector<std::pair<int, const std::vector<RGBA>*>>& layers,
-    int idx)
-{
-    RGBA ret(RGBA::BL.R, RGBA::BL.G, RGBA::BL.B, 0x00);
-    int o = -1;
-
-    for (auto& [l, v] : layers) {
-        if (idx < (int)v->size() && (*v)[idx].A == 0xff) { o = l; break; }
-    }
-
-    for (auto& [l, v] : layers) {
-        if (l < o || idx >= (int)v->size()) continue;
-        const RGBA& p = (*v)[idx];
-        switch (p.A) {
-            case 0: break;
-            case 0xff:
-                ret = RGBA(p.R, p.G, p.B, 0xff);
-                break;
-            default: {
-                unsigned int R = (p.R * p.A + ret.R * (0xff - p.A)) / 0xff;
-                unsigned int G = (p.G * p.A + ret.G * (0xff - p.A)) / 0xff;
-                unsigned int B = (p.B * p.A + ret.B * (0xff - p.A)) / 0xff;
-                ret = RGBA((unsigned char)R, (unsigned char)G, (unsigned char)B, 0xff);
-            }
-        }
-    }
-
-    return ret;
-}
-
 void drv::DRM::blit(int x, int y, int width, int height) {
 
     if (!_buffer.map) return;
 
-    std::vector<std::pair<int, const std::vector<RGBA>*>> layers;
-    if (!collect_layers(display->page_number(), layers)) return;
+    TRACE_SPAN("blit");
+
+    int page_no = display->page_number();
+    if (!display->canvas.contains(page_no)) return;
+
+    int x0 = x < 0 ? 0 : x;
+    int x1 = x + width < _pwidth ? x + width : _pwidth;
 
     bool any_written = false;
-    for (int _y = y; _y < y + height && _y < _pheight; _y++) {
-        for (int _x = x; _x < x + width && _x < _pwidth; _x++) {
-            int idx = _y * _pwidth + _x;
-            RGBA c = blend_pixel(layers, idx);
-            if (this->canvas[idx] != c) {
-                this->canvas[idx] = c;
-                write_pixel(_x, _y, c);
-                any_written = true;
-            }
-        }
-    }
+    for (int _y = y < 0 ? 0 : y; x0 < x1 && _y < y + height && _y < _pheight; _y++)
+        any_written |= blit_row(page_no, _y, x0, x1, false);
 
     if (any_written)
         mark_dirty();
@@ -365,24 +343,17 @@ void drv::DRM::blit_fullscreen() {
 
     if (!_buffer.map) return;
 
-    std::vector<std::pair<int, const std::vector<RGBA>*>> layers;
-    if (!collect_layers(display->page_number(), layers)) return;
+    TRACE_SPAN("blit_fullscreen");
+
+    int page_no = display->page_number();
+    if (!display->canvas.contains(page_no)) return;
 
     bool force = _force_full;
     _force_full = false;
 
     bool any_written = false;
-    for (int y = 0; y < _pheight; y++) {
-        for (int x = 0; x < _pwidth; x++) {
-            int idx = y * _pwidth + x;
-            RGBA c = blend_pixel(layers, idx);
-            if (force || this->canvas[idx] != c) {
-                this->canvas[idx] = c;
-                write_pixel(x, y, c);
-                any_written = true;
-            }
-        }
-    }
+    for (int y = 0; y < _pheight; y++)
+        any_written |= blit_row(page_no, y, 0, _pwidth, force);
 
     if (any_written || force)
         mark_dirty();
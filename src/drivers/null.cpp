@@ -0,0 +1,330 @@
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <stdexcept>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <gd.h>
+
+#include "throws.hpp"
+#include "common.hpp"
+#include "logger.hpp"
+#include "config.hpp"
+#include "display.hpp"
+#include "rgb.hpp"
+#include "trace.hpp"
+#include "driver.hpp"
+#include "drivers/null.hpp"
+
+static expr::VARIABLE fn_null_brightness(const expr::FUNCTION_ARGS& args);
+
+// Replaces first %d or %0Nd in pattern with frame number.
+static std::string frame_filename(const std::string& pattern, uint64_t frame) {
+
+    size_t pos = pattern.find('%');
+    if (pos == std::string::npos)
+        return pattern;
+
+    size_t end = pos + 1;
+    int digits = 0;
+    while (end < pattern.size() && pattern[end] >= '0' && pattern[end] <= '9')
+        digits = digits * 10 + (pattern[end++] - '0');
+
+    if (end >= pattern.size() || pattern[end] != 'd' || digits > 20)
+        return pattern;
+
+    std::string n = std::to_string(frame);
+    if ((int)n.size() < digits)
+        n.insert(0, digits - n.size(), '0');
+
+    return pattern.substr(0, pos) + n + pattern.substr(end + 1);
+}
+
+static bool is_frame_pattern(const std::string& pattern) {
+    return frame_filename(pattern, 0) != pattern;
+}
+
+drv::NUL::NUL(const std::string& device, int backlight, int bpp, int& width, int& height) {
+
+    if (width < 1 || height < 1)
+        throw std::runtime_error("null: invalid resolution " + std::to_string(width) + "x" + std::to_string(height));
+
+    if (bpp != 2 && bpp != 3 && bpp != 4)
+        throw std::runtime_error("null: unsupported bpp " + std::to_string(bpp) + ", use 2, 3 or 4");
+
+    _dev = device;
+    _bpp = bpp;
+    _pwidth = width;
+    _pheight = height;
+    _backlight = backlight;
+
+    _buffer.assign(static_cast<size_t>(_pwidth) * _pheight * _bpp, 0);
+    this->canvas.resize(_pwidth * _pheight, RGBA(RGBA::BLACK));
+
+    open_output();
+
+    logger::info["driver"] << "null: framebuffer " << _pwidth << "x" << _pheight
+                           << " bpp=" << _bpp
+                           << (_dev.empty() ? "" : ", output " + _dev) << std::endl;
+
+    this->backlight(backlight);
+
+    CONFIG::functions.append({"brightness", fn_null_brightness});
+    CONFIG::functions.append({"backlight",  fn_null_brightness});
+}
+
+drv::NUL::~NUL() {
+
+    CONFIG::functions.erase("brightness");
+    CONFIG::functions.erase("backlight");
+
+    if (_fd > STDERR_FILENO)
+        close(_fd);
+    _fd = -1;
+
+    logger::verbose["driver"] << "null: driver exiting after " << _frames << " frames" << std::endl;
+}
+
+const int drv::NUL::BPP() {
+    return _bpp;
+}
+
+void drv::NUL::open_output() {
+
+    if (_dev.empty())
+        return;
+
+    _png = _dev.size() > 4 && common::to_lower(_dev.substr(_dev.size() - 4)) == ".png";
+    _numbered = is_frame_pattern(_dev);
+
+    // PNG and numbered raw frames are written to files of their own
+    if (_png || _numbered)
+        return;
+
+    if (_dev == "-") {
+        _fd = STDOUT_FILENO;
+        return;
+    }
+
+    _fd = open(_dev.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_fd < 0)
+        throw std::runtime_error("null: failed to open " + _dev + ": " + strerror(errno));
+}
+
+void drv::NUL::write_pixel(int x, int y, const RGBA& c) {
+
+    uint8_t* p = _buffer.data() + (static_cast<size_t>(y) * _pwidth + x) * _bpp;
+
+    switch (_bpp) {
+        case 2: {
+            uint16_t v = c.RGB565();
+            p[0] = v & 0xff;
+            p[1] = v >> 8;
+            break;
+        }
+        case 3:
+            p[0] = c.R;
+            p[1] = c.G;
+            p[2] = c.B;
+            break;
+        default:
+            p[0] = c.R;
+            p[1] = c.G;
+            p[2] = c.B;
+            p[3] = 0xff;
+    }
+}
+
+// Reads back what the framebuffer holds, so that PNG output shows
+// the precision loss of the configured bpp.
+RGBA drv::NUL::read_pixel(int x, int y) const {
+
+    const uint8_t* p = _buffer.data() + (static_cast<size_t>(y) * _pwidth + x) * _bpp;
+
+    if (_bpp == 2) {
+        uint16_t v = p[0] | (p[1] << 8);
+        unsigned char R = (v >> 11) & 0x1f;
+        unsigned char G = (v >> 5) & 0x3f;
+        unsigned char B = v & 0x1f;
+        return RGBA((R << 3) | (R >> 2), (G << 2) | (G >> 4), (B << 3) | (B >> 2), 0xff);
+    }
+
+    return RGBA(p[0], p[1], p[2], 0xff);
+}
+
+bool drv::NUL::draw(int x, int y, int width, int height, bool force) {
+
+    TRACE_SPAN("draw");
+
+    int page_no = display->page_number();
+    if (!display->canvas.contains(page_no)) return false;
+
+    int x0 = x < 0 ? 0 : x;
+    int x1 = x + width < _pwidth ? x + width : _pwidth;
+
+    bool any_written = false;
+    for (int _y = y < 0 ? 0 : y; x0 < x1 && _y < y + height && _y < _pheight; _y++) {
+        _row.resize(x1 - x0);
+        compose(page_no, _y, x0, x1, _row.data());
+        for (int _x = x0; _x < x1; _x++) {
+            int idx = _y * _pwidth + _x;
+            const RGBA& c = _row[_x - x0];
+            if (force || this->canvas[idx] != c) {
+                this->canvas[idx] = c;
+                write_pixel(_x, _y, c);
+                any_written = true;
+            }
+        }
+    }
+
+    return any_written;
+}
+
+void drv::NUL::blit(int x, int y, int width, int height) {
+
+    if (draw(x, y, width, height, false))
+        present();
+}
+
+// All rects make up a single frame.
+void drv::NUL::blit(const std::vector<RECT>& rects) {
+
+    bool any_written = false;
+    for (const RECT& rect : rects)
+        any_written |= draw(rect.min.x, rect.min.y, rect.max.x - rect.min.x, rect.max.y - rect.min.y, false);
+
+    if (any_written)
+        present();
+}
+
+void drv::NUL::blit_fullscreen() {
+
+    bool force = _force_full;
+    _force_full = false;
+
+    if (draw(0, 0, _pwidth, _pheight, force) || force)
+        present();
+}
+
+void drv::NUL::clear() {
+
+    std::fill(this->canvas.begin(), this->canvas.end(), RGBA(RGBA::BLACK));
+    for (int y = 0; y < _pheight; y++)
+        for (int x = 0; x < _pwidth; x++)
+            write_pixel(x, y, RGBA(RGBA::BLACK));
+
+    present();
+}
+
+void drv::NUL::present() {
+
+    TRACE_SPAN("present");
+    _frames++;
+
+    if (_dev.empty())
+        return;
+
+    std::string filename = _numbered ? frame_filename(_dev, _frames) : _dev;
+
+    if (_png) {
+        write_png(filename);
+        return;
+    }
+
+    if (!_numbered) {
+        write_raw(_fd);
+        return;
+    }
+
+    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        logger::error["driver"] << "null: failed to open " << filename << ": " << strerror(errno) << std::endl;
+        return;
+    }
+
+    write_raw(fd);
+    close(fd);
+}
+
+void drv::NUL::write_raw(int fd) {
+
+    if (fd < 0) return;
+
+    size_t done = 0;
+    while (done < _buffer.size()) {
+        ssize_t n = write(fd, _buffer.data() + done, _buffer.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            logger::error["driver"] << "null: failed to write frame " << _frames << ": " << strerror(errno) << std::endl;
+            return;
+        }
+        done += n;
+    }
+}
+
+// Written to a temporary file and renamed, so readers never see a partial image.
+void drv::NUL::write_png(const std::string& filename) {
+
+    gdImagePtr im = gdImageCreateTrueColor(_pwidth, _pheight);
+    if (!im) {
+        logger::error["driver"] << "null: failed to allocate image for frame " << _frames << std::endl;
+        return;
+    }
+
+    for (int y = 0; y < _pheight; y++) {
+        for (int x = 0; x < _pwidth; x++) {
+            RGBA c = read_pixel(x, y);
+            gdImageSetPixel(im, x, y, gdTrueColorAlpha(c.R, c.G, c.B, 0));
+        }
+    }
+
+    int size = 0;
+    void* png = gdImagePngPtr(im, &size);
+    gdImageDestroy(im);
+
+    if (!png) {
+        logger::error["driver"] << "null: failed to encode frame " << _frames << std::endl;
+        return;
+    }
+
+    std::string tmpname = filename + ".tmp";
+    int fd = open(tmpname.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = fd >= 0 && write(fd, png, size) == size;
+
+    if (fd >= 0) close(fd);
+    gdFree(png);
+
+    if (!ok || rename(tmpname.c_str(), filename.c_str()) != 0) {
+        logger::error["driver"] << "null: failed to write " << filename << ": " << strerror(errno) << std::endl;
+        unlink(tmpname.c_str());
+    }
+}
+
+void drv::NUL::backlight(int value) {
+
+    if (value < 0) value = 0;
+    else if (value > 10) value = 10;
+
+    _backlight = value;
+}
+
+static expr::VARIABLE fn_null_brightness(const expr::FUNCTION_ARGS& args) {
+
+    if (!display || !display->driver) {
+        logger::error["function"] << "backlight: driver not available" << std::endl;
+        return (double)0;
+    }
+
+    if (args.empty())
+        return (double)display->driver->backlight();
+
+    if (!args[0].number_convertible().empty()) {
+        logger::error["function"] << "backlight: argument must be a number" << std::endl;
+        return (double)display->driver->backlight();
+    }
+
+    display->driver->backlight(args[0].to_int());
+    return (double)display->driver->backlight();
+}
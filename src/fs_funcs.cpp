@@ -1,5 +1,8 @@
 #include <filesystem>
 #include <fstream>
+#include <vector>
+#include <algorithm>
+#include <sys/vfs.h>
 
 #include "fs_funcs.hpp"
 
@@ -20,3 +23,24 @@ bool fs::is_readable(const std::string& filename) {
 	return fs::exists(filename) && fs::is_file(filename) &&
 		fs::is_accessible(filename);
 }
+
+bool fs::is_pseudo(const std::string& filename) {
+
+	static const std::vector<unsigned long> pseudo_fs = {
+		0x9fa0,		// proc
+		0x62656572,	// sysfs
+		0x64626720,	// debugfs
+		0x74726163,	// tracefs
+		0x27e0eb,	// cgroup
+		0x63677270,	// cgroup2
+		0x62656570,	// configfs
+		0x73636673,	// securityfs
+	};
+
+	struct statfs sfs;
+
+	if ( statfs(filename.c_str(), &sfs) != 0 )
+		return false;
+
+	return std::find(pseudo_fs.begin(), pseudo_fs.end(), (unsigned long)sfs.f_type) != pseudo_fs.end();
+}
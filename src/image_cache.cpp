@@ -0,0 +1,372 @@
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "logger.hpp"
+#include "image_cache.hpp"
+
+std::mutex IMAGE_CACHE::_m;
+std::list<std::pair<IMAGE_CACHE::KEY, std::shared_ptr<const IMAGE_CACHE::ENTRY>>> IMAGE_CACHE::_entries;
+size_t IMAGE_CACHE::_bytes = 0;
+std::string IMAGE_CACHE::_directory = "";
+std::map<uint64_t, IMAGE_CACHE::DISK_ENTRY> IMAGE_CACHE::_files;
+size_t IMAGE_CACHE::_disk_bytes = 0;
+bool IMAGE_CACHE::_scanned = false;
+
+// On-disk layout of a persisted entry: header, serialized key, raw pixels.
+// Bump version whenever the pixel format or key layout changes.
+struct CACHE_HEADER {
+	char magic[8];
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t keylen;
+};
+
+static constexpr char CACHE_MAGIC[8] = { 'L', 'C', 'D', '2', 'I', 'M', 'G', 0 };
+static constexpr uint32_t CACHE_VERSION = 2;
+
+const std::string IMAGE_CACHE::KEY::to_string() const {
+
+	return this -> path + "|" + std::to_string(this -> inode) + "|" + std::to_string(this -> mtime) + "|" +
+		std::to_string(this -> size) + "|" + std::to_string(this -> width) + "x" + std::to_string(this -> height) + "|" +
+		std::to_string(this -> scale) + "|" + ( this -> inverted ? "1" : "0" ) + "|" +
+		std::to_string(this -> opacity) + "|" + std::to_string(this -> center);
+}
+
+// FNV-1a over the serialized key; names the persisted file.
+uint64_t IMAGE_CACHE::KEY::hash() const {
+
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	for ( unsigned char ch : this -> to_string()) {
+		h ^= ch;
+		h *= 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+bool IMAGE_CACHE::stat(const std::string& path, KEY& key) {
+
+	struct stat st;
+
+	if ( ::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+		return false;
+
+	key.path = path;
+	key.inode = st.st_ino;
+	key.mtime = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+	key.size = st.st_size;
+	return true;
+}
+
+std::shared_ptr<const IMAGE_CACHE::ENTRY> IMAGE_CACHE::find(const KEY& key) {
+
+	{
+		std::lock_guard<std::mutex> lock(IMAGE_CACHE::_m);
+
+		for ( auto it = IMAGE_CACHE::_entries.begin(); it != IMAGE_CACHE::_entries.end(); it++ ) {
+
+			if ( it -> first == key ) {
+
+				if ( it != IMAGE_CACHE::_entries.begin())
+					IMAGE_CACHE::_entries.splice(IMAGE_CACHE::_entries.begin(), IMAGE_CACHE::_entries, it);
+
+				return IMAGE_CACHE::_entries.front().second;
+			}
+		}
+	}
+
+	std::shared_ptr<const ENTRY> entry = IMAGE_CACHE::load(key);
+
+	if ( entry != nullptr ) {
+
+		std::lock_guard<std::mutex> lock(IMAGE_CACHE::_m);
+		IMAGE_CACHE::_entries.emplace_front(key, entry);
+		IMAGE_CACHE::_bytes += entry -> bitmap.size() * sizeof(RGBA);
+		IMAGE_CACHE::evict();
+	}
+
+	return entry;
+}
+
+void IMAGE_CACHE::store(const KEY& key, const std::shared_ptr<const ENTRY>& entry) {
+
+	if ( entry == nullptr )
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(IMAGE_CACHE::_m);
+
+		for ( auto it = IMAGE_CACHE::_entries.begin(); it != IMAGE_CACHE::_entries.end(); it++ ) {
+
+			if ( it -> first == key ) {
+				IMAGE_CACHE::_bytes -= it -> second -> bitmap.size() * sizeof(RGBA);
+				IMAGE_CACHE::_entries.erase(it);
+				break;
+			}
+		}
+
+		IMAGE_CACHE::_entries.emplace_front(key, entry);
+		IMAGE_CACHE::_bytes += entry -> bitmap.size() * sizeof(RGBA);
+		IMAGE_CACHE::evict();
+	}
+
+	IMAGE_CACHE::save(key, *entry);
+}
+
+void IMAGE_CACHE::clear() {
+
+	std::lock_guard<std::mutex> lock(IMAGE_CACHE::_m);
+	IMAGE_CACHE::_entries.clear();
+	IMAGE_CACHE::_bytes = 0;
+}
+
+const std::string IMAGE_CACHE::directory() {
+
+	std::lock_guard<std::mutex> lock(IMAGE_CACHE::_m);
+	return IMAGE_CACHE::_directory;
+}
+
+void IMAGE_CACHE::directory(const std::string& path) {
+
+	std::lock_guard<std::mutex> lock(IMAGE_CACHE::_m);
+	IMAGE_CACHE::_directory = path;
+
+	while ( IMAGE_CACHE::_directory.size() > 1 && IMAGE_CACHE::_directory.back() == '/' )
+		IMAGE_CACHE::_directory.pop_back();
+
+	IMAGE_CACHE::_files.clear();
+	IMAGE_CACHE::_disk_bytes = 0;
+	IMAGE_CACHE::_scanned = false;
+}
+
+// Drops least recently used entries until the cache fits max_bytes; the most
+// recent entry is always kept, even if it alone exceeds the limit.
+// Caller holds _m.
+void IMAGE_CACHE::evict() {
+
+	while ( IMAGE_CACHE::_bytes > IMAGE_CACHE::max_bytes && IMAGE_CACHE::_entries.size() > 1 ) {
+
+		IMAGE_CACHE::_bytes -= IMAGE_CACHE::_entries.back().second -> bitmap.size() * sizeof(RGBA);
+		IMAGE_CACHE::_entries.pop_back();
+	}
+}
+
+// Persisted files are kept apart from anything else in configured directory
+static std::string cache_directory(const std::string& directory) {
+
+	return directory.empty() ? directory : ( directory + "/images" );
+}
+
+static std::string cache_filename(const std::string& directory, uint64_t hash) {
+
+	char name[24];
+	snprintf(name, sizeof(name), "%016llx.raw", (unsigned long long)hash);
+	return directory + "/" + name;
+}
+
+static int64_t now_ns() {
+
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Whether name is one cache_filename() gives, and file starts with header of
+// current version; hash of the name is returned in hash.
+static bool cache_file(const std::string& directory, const std::string& name, uint64_t& hash) {
+
+	if ( name.size() != 20 || !name.ends_with(".raw") ||
+		!std::all_of(name.begin(), name.begin() + 16, [](char ch) { return std::isdigit((unsigned char)ch) || ( ch >= 'a' && ch <= 'f' ); }))
+		return false;
+
+	int fd = ::open(( directory + "/" + name ).c_str(), O_RDONLY | O_CLOEXEC);
+
+	if ( fd < 0 )
+		return false;
+
+	CACHE_HEADER hdr;
+	bool ok = ::read(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr) &&
+		std::memcmp(hdr.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 && hdr.version == CACHE_VERSION;
+
+	::close(fd);
+
+	if ( ok )
+		hash = std::strtoull(name.substr(0, 16).c_str(), nullptr, 16);
+
+	return ok;
+}
+
+std::shared_ptr<const IMAGE_CACHE::ENTRY> IMAGE_CACHE::load(const KEY& key) {
+
+	std::string dir = cache_directory(IMAGE_CACHE::directory());
+
+	if ( dir.empty())
+		return nullptr;
+
+	uint64_t hash = key.hash();
+	std::string filename = cache_filename(dir, hash);
+	std::string skey = key.to_string();
+
+	int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+
+	if ( fd < 0 )
+		return nullptr;
+
+	struct stat st;
+
+	if ( fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CACHE_HEADER)) {
+		::close(fd);
+		return nullptr;
+	}
+
+	// file's modification time is its last use, prune() removes oldest first
+	futimens(fd, nullptr);
+
+	size_t len = st.st_size;
+	void *map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+
+	if ( map == MAP_FAILED )
+		return nullptr;
+
+	const unsigned char *data = (const unsigned char*)map;
+	CACHE_HEADER hdr;
+	std::memcpy(&hdr, data, sizeof(hdr));
+
+	size_t pixels = (size_t)hdr.width * (size_t)hdr.height;
+	std::shared_ptr<ENTRY> entry = nullptr;
+
+	if ( std::memcmp(hdr.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 && hdr.version == CACHE_VERSION &&
+		hdr.keylen == skey.size() && len == sizeof(hdr) + hdr.keylen + pixels * sizeof(RGBA) &&
+		std::memcmp(data + sizeof(hdr), skey.data(), skey.size()) == 0 ) {
+
+		entry = std::make_shared<ENTRY>();
+		entry -> width = hdr.width;
+		entry -> height = hdr.height;
+		entry -> bitmap.resize(pixels);
+		std::memcpy((void*)entry -> bitmap.data(), data + sizeof(hdr) + hdr.keylen, pixels * sizeof(RGBA));
+
+		logger::vverbose["cache"] << "loaded cached image for " << key.path << " from " << filename << std::endl;
+
+		std::lock_guard<std::mutex> lock(IMAGE_CACHE::_m);
+
+		if ( auto it = IMAGE_CACHE::_files.find(hash); it != IMAGE_CACHE::_files.end())
+			it -> second.used = now_ns();
+	}
+
+	munmap(map, len);
+	return entry;
+}
+
+void IMAGE_CACHE::save(const KEY& key, const ENTRY& entry) {
+
+	std::string dir = cache_directory(IMAGE_CACHE::directory());
+
+	if ( dir.empty())
+		return;
+
+	if ( ::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST ) {
+		logger::warning["cache"] << "failed to create image cache directory " << dir << ": " << std::strerror(errno) << std::endl;
+		return;
+	}
+
+	uint64_t hash = key.hash();
+	std::string filename = cache_filename(dir, hash);
+	std::string tmpname = filename + ".tmp";
+	std::string skey = key.to_string();
+
+	CACHE_HEADER hdr;
+	std::memcpy(hdr.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	hdr.version = CACHE_VERSION;
+	hdr.width = entry.width;
+	hdr.height = entry.height;
+	hdr.keylen = skey.size();
+
+	int fd = ::open(tmpname.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+	if ( fd < 0 ) {
+		logger::warning["cache"] << "failed to persist image cache entry " << tmpname << ": " << std::strerror(errno) << std::endl;
+		return;
+	}
+
+	size_t pixels_len = entry.bitmap.size() * sizeof(RGBA);
+	bool ok = ::write(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr) &&
+		::write(fd, skey.data(), skey.size()) == (ssize_t)skey.size() &&
+		::write(fd, (const void*)entry.bitmap.data(), pixels_len) == (ssize_t)pixels_len;
+
+	::close(fd);
+
+	if ( !ok || ::rename(tmpname.c_str(), filename.c_str()) != 0 ) {
+		logger::warning["cache"] << "failed to persist image cache entry " << filename << ": " << std::strerror(errno) << std::endl;
+		::unlink(tmpname.c_str());
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(IMAGE_CACHE::_m);
+
+	if ( !IMAGE_CACHE::_scanned )
+		IMAGE_CACHE::scan(dir);
+
+	DISK_ENTRY& file = IMAGE_CACHE::_files[hash];
+	IMAGE_CACHE::_disk_bytes += sizeof(hdr) + skey.size() + pixels_len - file.size;
+	file.size = sizeof(hdr) + skey.size() + pixels_len;
+	file.used = now_ns();
+
+	IMAGE_CACHE::prune(dir, hash);
+}
+
+// Lists entry files persisted by earlier runs. Caller holds _m.
+void IMAGE_CACHE::scan(const std::string& dir) {
+
+	std::error_code ec;
+
+	IMAGE_CACHE::_scanned = true;
+
+	for ( const auto& e : std::filesystem::directory_iterator(dir, ec)) {
+
+		std::string path = e.path().string();
+		uint64_t hash;
+		struct stat st;
+
+		if ( ::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) || !cache_file(dir, e.path().filename().string(), hash))
+			continue;
+
+		IMAGE_CACHE::_files[hash] = { .used = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec, .size = (size_t)st.st_size };
+		IMAGE_CACHE::_disk_bytes += st.st_size;
+	}
+
+	logger::vverbose["cache"] << "image cache " << dir << " has " << IMAGE_CACHE::_files.size() << " files, " <<
+		IMAGE_CACHE::_disk_bytes / 1024 << " KiB" << std::endl;
+}
+
+// Removes least recently used entry files until they fit max_disk_bytes;
+// keep, the file just written, stays. Caller holds _m.
+void IMAGE_CACHE::prune(const std::string& dir, uint64_t keep) {
+
+	while ( IMAGE_CACHE::_disk_bytes > IMAGE_CACHE::max_disk_bytes && IMAGE_CACHE::_files.size() > 1 ) {
+
+		auto oldest = IMAGE_CACHE::_files.end();
+
+		for ( auto it = IMAGE_CACHE::_files.begin(); it != IMAGE_CACHE::_files.end(); it++ )
+			if ( it -> first != keep && ( oldest == IMAGE_CACHE::_files.end() || it -> second.used < oldest -> second.used ))
+				oldest = it;
+
+		std::string filename = cache_filename(dir, oldest -> first);
+
+		if ( ::unlink(filename.c_str()) != 0 && errno != ENOENT )
+			logger::warning["cache"] << "failed to remove cached image " << filename << ": " << std::strerror(errno) << std::endl;
+		else logger::vverbose["cache"] << "removed cached image " << filename << std::endl;
+
+		IMAGE_CACHE::_disk_bytes -= oldest -> second.size;
+		IMAGE_CACHE::_files.erase(oldest);
+	}
+}
@@ -12,6 +12,7 @@
 #include "plugin_classes.hpp"
 #include "widget_classes.hpp"
 #include "expr/expression.hpp"
+#include "trace.hpp"
 #include "display.hpp"
 #include "timer.hpp"
 #include "layout.hpp"
@@ -239,6 +240,56 @@ std::vector<int> LAYOUT::parse_page_sequence(const std::string& s) {
 	return vec;
 }
 
+void LAYOUT::parse_transition(const std::string& key, const CONFIG::NODE& value, TRANSITION::STYLE& style, const std::string& where) {
+
+	if ( !std::holds_alternative<std::string>(value)) {
+
+		logger::error["config"] << "syntax error, " << key << " on " << where << " cannot be array or object value" << std::endl;
+		return;
+	}
+
+	std::string s = common::unquoted(common::to_lower(common::trim_ws(std::as_const(std::get<std::string>(value)))));
+
+	if ( key == "transition" ) {
+
+		if ( !TRANSITION::parse(s, style.type))
+			logger::error["config"] << "unknown transition '" << s << "' on " << where <<
+				", available transitions are none, fade, slide_left, slide_right, wipe_left and wipe_right" << std::endl;
+		return;
+	}
+
+	int ms = -1;
+
+	if ( !s.empty() && s.find_first_not_of("1234567890") == std::string::npos ) {
+
+		try {
+			ms = std::stoi(s);
+		} catch ( const std::exception& ) {}
+	}
+
+	if ( ms <= 0 )
+		logger::error["config"] << "syntax error, transition_time on " << where << " must be a positive number of milliseconds, not '" << s << "'" << std::endl;
+	else style.duration = ms;
+}
+
+TRANSITION::STYLE LAYOUT::transition_to(int page_no) {
+
+	TRANSITION::STYLE style = this -> transition;
+
+	if ( this -> pages.contains(page_no)) {
+
+		const TRANSITION::STYLE& page = this -> pages[page_no].transition;
+
+		if ( page.type != TRANSITION::INHERIT )
+			style.type = page.type;
+
+		if ( page.duration > 0 )
+			style.duration = page.duration;
+	}
+
+	return style;
+}
+
 LAYOUT::WIDGET_LINK::WIDGET_LINK(const std::string& key, const std::string& value) {
 
 	if ( parse_coords(value, this -> x, this -> y)) {
@@ -251,28 +302,22 @@ LAYOUT::WIDGET_LINK::WIDGET_LINK(const std::string& key, const std::string& valu
 
 widget::WIDGET* LAYOUT::WIDGET_LINK::get_ptr() {
 
-	if ( !display -> widgets -> contains(this -> name))
-		return nullptr;
+	if ( this -> ptr == nullptr && display -> widgets -> contains(this -> name))
+		this -> ptr = display -> widgets -> widgets[this -> name].get();
 
-	return display -> widgets -> widgets[this -> name].get();
+	return this -> ptr;
 }
 
 bool LAYOUT::WIDGET_LINK::reloads() {
 
-	if ( !display -> widgets -> contains(this -> name))
-		return false;
-
-	auto *w = display -> widgets -> widgets[this -> name].get();
-	return w -> reloads();
+	auto *w = this -> get_ptr();
+	return w == nullptr ? false : w -> reloads();
 }
 
 bool LAYOUT::WIDGET_LINK::update() {
 
-	if ( !display -> widgets -> contains(this -> name))
-		return false;
-
-	auto *w = display -> widgets -> widgets[this -> name].get();
-	return w -> update();
+	auto *w = this -> get_ptr();
+	return w == nullptr ? false : w -> update();
 }
 
 void LAYOUT::PAGE::update_widgets() {
@@ -346,7 +391,8 @@ LAYOUT::LAYOUT(CONFIG::MAP *cfg) {
 			logger::error["config"] << "syntax error, '" << key << "', layers must be placed inside pages" << std::endl;
 			continue;
 
-		} else if ( key != "timers" && key != "default" && key != "sequence" && !key.starts_with("page") && key != "goodbye" ) {
+		} else if ( key != "timers" && key != "default" && key != "sequence" && !key.starts_with("page") && key != "goodbye" &&
+				key != "transition" && key != "transition_time" ) {
 
 			logger::error["config"] << "syntax error, unknown key '" << key << "' for section layout, ignoring" << std::endl;
 			continue;
@@ -405,6 +451,11 @@ LAYOUT::LAYOUT(CONFIG::MAP *cfg) {
 			logger::error["config"] << "syntax error, page sequence in section layout, must be a comma separated list of numbers, not array or object" << std::endl;
 			continue;
 
+		} else if ( key == "transition" || key == "transition_time" ) {
+
+			this -> parse_transition(key, v, this -> transition, "layout");
+			continue;
+
 		} else if ( key == "timers" && !std::holds_alternative<CONFIG::VECTOR>(v)) {
 
 			logger::error["config"] << "syntax error, timers in section layout, must be array" << std::endl;
@@ -488,7 +539,8 @@ LAYOUT::LAYOUT(CONFIG::MAP *cfg) {
 					logger::error["config"] << "syntax error, goodbye page does not support timers" << std::endl;
 					continue;
 
-				} else if ( key2 != "timers" && key2 != "on_enter" && key2 != "on_exit" && !key2.starts_with("layer")) {
+				} else if ( key2 != "timers" && key2 != "on_enter" && key2 != "on_exit" && !key2.starts_with("layer") &&
+						key2 != "transition" && key2 != "transition_time" ) {
 
 					if ( std::holds_alternative<std::string>(v2)) {
 						try {
@@ -521,6 +573,11 @@ LAYOUT::LAYOUT(CONFIG::MAP *cfg) {
 
 					continue;
 
+				} else if ( key2 == "transition" || key2 == "transition_time" ) {
+
+					this -> parse_transition(key2, v2, this -> pages[page_no].transition, page_name(page_no));
+					continue;
+
 				} else if ( key2 == "timers" && !std::holds_alternative<CONFIG::VECTOR>(v2)) {
 
 					logger::error["config"] << "syntax error, timers in section layout, must be array" << std::endl;
@@ -759,6 +816,10 @@ const std::string LAYOUT::dump() {
 
 	ss << "\n\tdefault " << this -> default_page << "\n";
 
+	if ( this -> transition.type != TRANSITION::NONE )
+		ss << "\ttransition " << TRANSITION::name(this -> transition.type) << "\n" <<
+			"\ttransition_time " << this -> transition.duration << "\n";
+
 	for ( const auto& page : this -> pages ) {
 
 		ss << "\n\tpage " << page.second.number << " {" <<
@@ -772,6 +833,11 @@ const std::string LAYOUT::dump() {
 		if ( !page.second.on_exit.empty())
 			ss << "\t\ton_exit  " << page.second.on_exit << "\n";
 
+		if ( page.second.transition.type != TRANSITION::INHERIT )
+			ss << "\t\ttransition " << TRANSITION::name(page.second.transition.type) << "\n";
+		if ( page.second.transition.duration > 0 )
+			ss << "\t\ttransition_time " << page.second.transition.duration << "\n";
+
 		for ( const auto& layer : page.second.layers ) {
 
 			ss << "\n\t\tlayer " << layer.second.number << " {" << "\n";
@@ -806,73 +872,99 @@ const std::string LAYOUT::dump() {
 	return ss.str();
 }
 
-void LAYOUT::render(int* forced_page, bool all) {
+// Resolves every widget link on every page to its widget, in compositing
+// order: draw n of page is drawn to surface n of page on canvas. Must be
+// re-run whenever widgets or layout are re-created.
+void LAYOUT::compile() {
 
-	for ( auto& [page_no, page] : this -> pages ) {
+	this -> compiled.clear();
 
-		if ( !all && (
-			( forced_page != nullptr && *forced_page != page_no ) ||
-			( forced_page == nullptr && display -> _page != page_no )))
-			continue;
-
-		for ( auto& [layer_no, layer] : this -> pages[page_no].layers ) {
+	for ( auto& [page_no, page] : this -> pages ) {
 
-			std::vector<std::string> missing_widgets;
+		std::vector<DRAW>& draws = this -> compiled[page_no];
 
-			for ( auto& widget : layer.widgets ) {
+		for ( auto& [layer_no, layer] : page.layers ) {
 
-				if ( !display -> widgets -> contains(widget.name)) {
+			for ( auto& link : layer.widgets ) {
 
-					if ( std::find(missing_widgets.begin(), missing_widgets.end(), widget.name) ==
-						missing_widgets.end()) {
+				link.ptr = nullptr;
 
-						logger::error["layout"] << "failed to render widget '" << widget.name <<
-							"', widget not initialized" << std::endl;
+				if ( link.get_ptr() == nullptr ) {
 
-						missing_widgets.push_back(widget.name);
-					}
+					logger::error["layout"] << "failed to render widget '" << link.name <<
+						"', widget not initialized" << std::endl;
 					continue;
 				}
 
-				// clear out previous widget bitmap, as size might have changed..
-				auto *w = display -> widgets -> widgets[widget.name].get();
+				draws.push_back({
+					.name = link.name,
+					.ptr = link.ptr,
+					.layer = layer_no,
+					.x = link.x,
+					.y = link.y,
+				});
+			}
+		}
+	}
+}
 
-				if ( w == nullptr && std::find(missing_widgets.begin(), missing_widgets.end(), widget.name) ==
-					missing_widgets.end()) {
+void LAYOUT::render(int* forced_page, bool all) {
 
-					missing_widgets.push_back(widget.name);
-					continue;
-				}
+	TRACE_SPAN("layout_render");
+
+	for ( auto& [page_no, draws] : this -> compiled ) {
+
+		if ( !all && (
+			( forced_page != nullptr && *forced_page != page_no ) ||
+			( forced_page == nullptr && display -> _page != page_no )))
+			continue;
 
-				for ( int y = 0; y < w -> previous_height(); y++ )
-					for ( int x = 0; x < w -> previous_width(); x++ )
-						display -> add_pixel(widget.x + x, widget.y + y, page_no, layer_no,
-							RGBA(RGBA::NO));
+		// pages without canvas are rendered in full when they are used
+		if ( all && !display -> canvas.allocated(page_no))
+			continue;
 
-				// draw bitmap
-				for ( int y = 0; y < w -> height(); y++ )
-					for ( int x = 0; x < w -> width(); x++ ) {
+		CANVAS::PAGE *page = display -> canvas.page(page_no);
 
-						try {
-							display -> add_pixel(widget.x + x, widget.y + y,
-							page_no, layer_no, w -> bitmap[(y * w -> width()) + x]);
+		if ( page == nullptr || page -> surfaces.size() != draws.size())
+			continue;
 
-						} catch (const std::runtime_error& e) {
+		for ( size_t i = 0; i < draws.size(); i++ ) {
 
-							logger::warning["render"] << e.what() << std::endl;
-						}
-					}
-			}
+			DRAW& d = draws[i];
+			widget::WIDGET *w = d.ptr;
+			CANVAS::SURFACE& surface = page -> surfaces[i];
+			RECT before = surface.rect;
+			RECT rect(d.x, d.y, d.x + w -> width(), d.y + w -> height());
+
+			// only surfaces that are new, moved or behind their widget's
+			// bitmap are copied; the rest of the page is as it was
+			if ( d.placement.at(rect) && surface.generation == w -> generation())
+				continue;
+
+			if ( !d.placement.at(rect))
+				display -> place(d.placement, rect);
+
+			surface.generation = w -> generation();
 
-			for ( std::string widget : missing_widgets ) {
+			if ( w -> bitmap.size() < (size_t)( w -> width() * w -> height())) {
 
-				layer.widgets.erase(
-					std::remove_if(layer.widgets.begin(), layer.widgets.end(), [&](LAYOUT::WIDGET_LINK const& w) {
-						return w.name == widget;
-					}), layer.widgets.end());
+				if ( !d.reported )
+					logger::warning["render"] << "widget '" << d.name << "' bitmap is smaller than its size" << std::endl;
+
+				d.reported = true;
+				display -> blit(surface, RECT(), nullptr);
+
+			} else if ( !display -> blit(surface, d.placement, w -> bitmap.data()) && !d.reported ) {
+
+				logger::warning["render"] << "widget '" << d.name << "' at " << d.x << "," << d.y << " size " <<
+					w -> width() << "x" << w -> height() << " does not fit on display, clipped" << std::endl;
+				d.reported = true;
 			}
 
+			// surface moved or was resized, grid index is rebuilt on next compose
+			if ( surface.rect.min.x != before.min.x || surface.rect.min.y != before.min.y ||
+				surface.rect.max.x != before.max.x || surface.rect.max.y != before.max.y )
+				page -> indexed = false;
 		}
 	}
-
 }
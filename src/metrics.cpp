@@ -0,0 +1,390 @@
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <sstream>
+#include <vector>
+#include <iomanip>
+#include <condition_variable>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "logger.hpp"
+#include "metrics.hpp"
+
+// How often the socket thread checks for a stop request while idle.
+static constexpr int ACCEPT_POLL_MS = 250;
+
+// How long a client has to send its request before it is answered anyway.
+static constexpr int REQUEST_WAIT_MS = 100;
+
+static const std::vector<double> QUANTILES = { 0.5, 0.9, 0.99, 0.999 };
+
+int HISTOGRAM::index(uint64_t ns) {
+
+	if ( ns < ( 1ULL << MIN_EXP ))
+		return 0;
+
+	int e = std::bit_width(ns) - 1;
+
+	if ( e > MAX_EXP )
+		return BUCKETS - 1;
+
+	int sub = ( ns >> ( e - SUB_BITS )) & ( SUB_BUCKETS - 1 );
+	return 1 + ( e - MIN_EXP ) * SUB_BUCKETS + sub;
+}
+
+uint64_t HISTOGRAM::upper_bound(int index) {
+
+	if ( index <= 0 )
+		return 1ULL << MIN_EXP;
+
+	int e = MIN_EXP + ( index - 1 ) / SUB_BUCKETS;
+	int sub = ( index - 1 ) % SUB_BUCKETS;
+	return (uint64_t)( SUB_BUCKETS + sub + 1 ) << ( e - SUB_BITS );
+}
+
+void HISTOGRAM::record(uint64_t ns) {
+
+	this -> _buckets[HISTOGRAM::index(ns)].fetch_add(1, std::memory_order_relaxed);
+	this -> _sum.fetch_add(ns, std::memory_order_relaxed);
+	this -> _count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HISTOGRAM::record(std::chrono::steady_clock::duration d) {
+
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+	this -> record(ns < 0 ? (uint64_t)0 : (uint64_t)ns);
+}
+
+uint64_t HISTOGRAM::count() const {
+	return this -> _count.load(std::memory_order_relaxed);
+}
+
+uint64_t HISTOGRAM::sum() const {
+	return this -> _sum.load(std::memory_order_relaxed);
+}
+
+uint64_t HISTOGRAM::quantile(double q) const {
+
+	uint64_t total = 0;
+
+	for ( const auto& b : this -> _buckets )
+		total += b.load(std::memory_order_relaxed);
+
+	if ( total == 0 )
+		return 0;
+
+	uint64_t target = (uint64_t)std::ceil(q * total);
+	uint64_t seen = 0;
+
+	for ( int i = 0; i < BUCKETS; i++ )
+		if ( seen += this -> _buckets[i].load(std::memory_order_relaxed); seen >= target && seen > 0 )
+			return HISTOGRAM::upper_bound(i);
+
+	return HISTOGRAM::upper_bound(BUCKETS - 1);
+}
+
+uint64_t HISTOGRAM::count_below(uint64_t ns) const {
+
+	uint64_t n = 0;
+
+	for ( int i = 0; i < BUCKETS && HISTOGRAM::upper_bound(i) <= ns; i++ )
+		n += this -> _buckets[i].load(std::memory_order_relaxed);
+
+	return n;
+}
+
+METRICS::~METRICS() {
+
+	this -> close();
+}
+
+HISTOGRAM& METRICS::histogram(const std::string& family, const std::string& label, const std::string& value) {
+
+	std::lock_guard<std::mutex> lock(this -> _m);
+	FAMILY& f = this -> _histograms[family];
+
+	if ( f.label.empty())
+		f.label = label;
+
+	auto& h = f.series[value];
+
+	if ( h == nullptr )
+		h = std::make_unique<HISTOGRAM>();
+
+	return *h;
+}
+
+std::atomic<uint64_t>& METRICS::counter(const std::string& name) {
+
+	std::lock_guard<std::mutex> lock(this -> _m);
+	auto& c = this -> _counters[name];
+
+	if ( c == nullptr )
+		c = std::make_unique<COUNTER>();
+
+	return c -> value;
+}
+
+void METRICS::describe(const std::string& name, const std::string& help) {
+
+	std::lock_guard<std::mutex> lock(this -> _m);
+
+	if ( name.ends_with("_total")) {
+
+		auto& c = this -> _counters[name];
+
+		if ( c == nullptr )
+			c = std::make_unique<COUNTER>();
+
+		c -> help = help;
+
+	} else this -> _histograms[name].help = help;
+}
+
+static std::string seconds(uint64_t ns) {
+
+	std::stringstream ss;
+	ss << std::setprecision(9) << ( (double)ns / 1e9 );
+	return ss.str();
+}
+
+static std::string escape(const std::string& s) {
+
+	std::string ret;
+
+	for ( char ch : s ) {
+
+		if ( ch == '\\' || ch == '"' )
+			ret += '\\';
+		else if ( ch == '\n' ) {
+			ret += "\\n";
+			continue;
+		}
+
+		ret += ch;
+	}
+
+	return ret;
+}
+
+// Histograms are exported with one bucket per power of two, which keeps
+// boundaries fixed and aggregatable; quantiles from the full resolution
+// buckets are exported next to them as gauges.
+const std::string METRICS::dump() {
+
+	std::stringstream os;
+	std::lock_guard<std::mutex> lock(this -> _m);
+
+	for ( const auto& [name, c] : this -> _counters ) {
+
+		if ( !c -> help.empty())
+			os << "# HELP " << name << " " << c -> help << "\n";
+
+		os << "# TYPE " << name << " counter\n" <<
+			name << " " << c -> value.load(std::memory_order_relaxed) << "\n";
+	}
+
+	for ( const auto& [name, f] : this -> _histograms ) {
+
+		if ( f.series.empty())
+			continue;
+
+		std::string base = name.ends_with("_seconds") ? name.substr(0, name.size() - 8) : name;
+
+		if ( !f.help.empty())
+			os << "# HELP " << name << " " << f.help << "\n";
+
+		os << "# TYPE " << name << " histogram\n";
+
+		for ( const auto& [value, h] : f.series ) {
+
+			std::string label = f.label.empty() ? "" : ( f.label + "=\"" + escape(value) + "\"" );
+			std::string sep = label.empty() ? "" : ",";
+			uint64_t count = h -> count();
+
+			for ( int e = HISTOGRAM::MIN_EXP; e <= HISTOGRAM::MAX_EXP; e++ )
+				os << name << "_bucket{" << label << sep << "le=\"" << seconds(1ULL << e) << "\"} " <<
+					h -> count_below(1ULL << e) << "\n";
+
+			os << name << "_bucket{" << label << sep << "le=\"+Inf\"} " << count << "\n" <<
+				name << "_sum" << ( label.empty() ? "" : "{" + label + "}" ) << " " << seconds(h -> sum()) << "\n" <<
+				name << "_count" << ( label.empty() ? "" : "{" + label + "}" ) << " " << count << "\n";
+		}
+
+		os << "# TYPE " << base << "_quantile_seconds gauge\n";
+
+		for ( const auto& [value, h] : f.series ) {
+
+			std::string label = f.label.empty() ? "" : ( f.label + "=\"" + escape(value) + "\"," );
+
+			for ( double q : QUANTILES )
+				os << base << "_quantile_seconds{" << label << "quantile=\"" << q << "\"} " << seconds(h -> quantile(q)) << "\n";
+		}
+	}
+
+	return os.str();
+}
+
+const std::string METRICS::endpoint() const {
+	return this -> _endpoint;
+}
+
+bool METRICS::listen(const std::string& endpoint, int interval) {
+
+	this -> close();
+
+	if ( endpoint.empty())
+		return true;
+
+	this -> _endpoint = endpoint;
+	this -> _interval = interval < 100 ? 100 : interval;
+
+	if ( !endpoint.starts_with("unix:")) {
+
+		this -> _thread = std::jthread([this](std::stop_token t){ this -> file_loop(t); });
+		logger::verbose["metrics"] << "writing metrics to " << endpoint << " every " << this -> _interval << "ms" << std::endl;
+		return true;
+	}
+
+	std::string path = endpoint.substr(5);
+	struct sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+
+	if ( path.empty() || path.size() >= sizeof(addr.sun_path)) {
+
+		logger::error["metrics"] << "invalid metrics socket path '" << path << "'" << std::endl;
+		this -> _endpoint = "";
+		return false;
+	}
+
+	std::memcpy(addr.sun_path, path.c_str(), path.size());
+
+	// stale socket from previous run; never remove anything else
+	if ( struct stat st; ::lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+		::unlink(path.c_str());
+
+	if ( this -> _fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0); this -> _fd < 0 ||
+		::bind(this -> _fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(this -> _fd, 4) != 0 ) {
+
+		logger::error["metrics"] << "failed to listen on " << path << ": " << std::strerror(errno) << std::endl;
+
+		if ( this -> _fd >= 0 )
+			::close(this -> _fd);
+
+		this -> _fd = -1;
+		this -> _endpoint = "";
+		return false;
+	}
+
+	this -> _thread = std::jthread([this](std::stop_token t){ this -> socket_loop(t); });
+	logger::verbose["metrics"] << "serving metrics on " << path << std::endl;
+	return true;
+}
+
+void METRICS::close() {
+
+	if ( this -> _thread.joinable()) {
+		this -> _thread.request_stop();
+		this -> _thread.join();
+	}
+
+	if ( this -> _fd >= 0 ) {
+
+		::close(this -> _fd);
+		::unlink(this -> _endpoint.substr(5).c_str());
+	}
+
+	this -> _fd = -1;
+	this -> _endpoint = "";
+}
+
+void METRICS::write_file() {
+
+	std::string data = this -> dump();
+	std::string tmpname = this -> _endpoint + ".tmp";
+
+	int fd = ::open(tmpname.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	bool ok = fd >= 0 && ::write(fd, data.data(), data.size()) == (ssize_t)data.size();
+
+	if ( fd >= 0 )
+		::close(fd);
+
+	if ( !ok || ::rename(tmpname.c_str(), this -> _endpoint.c_str()) != 0 ) {
+
+		logger::warning["metrics"] << "failed to write " << this -> _endpoint << ": " << std::strerror(errno) << std::endl;
+		::unlink(tmpname.c_str());
+	}
+}
+
+void METRICS::file_loop(std::stop_token token) {
+
+	std::mutex m;
+	std::condition_variable_any cv;
+	std::unique_lock<std::mutex> lock(m);
+
+	while ( !token.stop_requested()) {
+
+		this -> write_file();
+		cv.wait_for(lock, token, std::chrono::milliseconds(this -> _interval), []{ return false; });
+	}
+
+	// final state for whoever reads the file after exit
+	this -> write_file();
+}
+
+void METRICS::serve(int client) {
+
+	char buf[1024];
+	ssize_t len = 0;
+	struct pollfd pfd = { .fd = client, .events = POLLIN, .revents = 0 };
+
+	if ( poll(&pfd, 1, REQUEST_WAIT_MS) > 0 && ( pfd.revents & POLLIN ))
+		len = ::read(client, buf, sizeof(buf));
+
+	std::string body = this -> dump();
+	std::string data = len >= 4 && std::strncmp(buf, "GET ", 4) == 0 ?
+		"HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+			std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body : body;
+
+	for ( size_t done = 0; done < data.size(); ) {
+
+		ssize_t n = ::send(client, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+
+		if ( n < 0 && errno == EINTR )
+			continue;
+		else if ( n <= 0 )
+			break;
+
+		done += n;
+	}
+}
+
+void METRICS::socket_loop(std::stop_token token) {
+
+	struct pollfd pfd = { .fd = this -> _fd, .events = POLLIN, .revents = 0 };
+
+	while ( !token.stop_requested()) {
+
+		if ( int r = poll(&pfd, 1, ACCEPT_POLL_MS); r <= 0 || !( pfd.revents & POLLIN ))
+			continue;
+
+		int client = ::accept4(this -> _fd, nullptr, nullptr, SOCK_CLOEXEC);
+
+		if ( client < 0 )
+			continue;
+
+		// a client that stops reading must not stall the thread
+		struct timeval tv = { .tv_sec = 1, .tv_usec = 0 };
+		::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+		this -> serve(client);
+		::close(client);
+	}
+}
@@ -6,6 +6,7 @@
 #include "plugin_classes.hpp"
 
 common::lowercase_map<bool> plugin::types = {
+	{ "fs", true },
 #ifdef WITH_UBUS
 	{ "ubus", true }
 #endif
@@ -56,12 +57,17 @@ void plugin::add(const std::string& name, CONFIG::MAP *cfg) {
 		return;
 	}
 
-	if ( common::is_any_of(_name, { "exec", "cpuinfo", "meminfo", "netinfo", "file", "test", "uname", "fs", "uptime" })) {
+	if ( common::is_any_of(_name, { "exec", "cpuinfo", "meminfo", "netinfo", "file", "test", "uname", "uptime" })) {
 
 		logger::notice["config"] << "plugin " << _name << " does not have anything to configure" << std::endl;
 		return;
 	}
 
+	if ( _name == "fs" ) {
+		plugin::FS::configure(cfg);
+		return;
+	}
+
 #ifdef WITH_UBUS
 	if ( _name == "ubus" ) {
 		plugin::UBUS::configure(cfg);
@@ -1,14 +1,85 @@
 #include <cstdint>
+#include <vector>
+#include <algorithm>
 
 #include "logger.hpp"
 #include "throws.hpp"
 #include "plugin.hpp"
+#include "procfile.hpp"
 #include "cpu/cpu.hpp"
 #include "plugins/cpuinfo.hpp"
 
+// cpu_t provides the static /proc/cpuinfo fields, which are refreshed only
+// every INFO_INTERVAL; load is computed from /proc/stat deltas by this plugin.
+static constexpr std::chrono::milliseconds INFO_INTERVAL = std::chrono::milliseconds(10000);
+
+// Per cpu jiffy counters of /proc/stat, index 0 is the aggregate "cpu" line
+// and index n + 1 is cpu<n>. Vectors are kept between samples to avoid
+// re-allocation.
+struct CPU_SAMPLE {
+	std::vector<uint64_t> busy;
+	std::vector<uint64_t> total;
+	std::vector<double> load;
+	size_t cores = 0;
+};
+
 static cpu_t *cpu = nullptr;
+static PROCFILE *stat_file = nullptr;
+static CPU_SAMPLE sample;
+static std::chrono::milliseconds info_updated = std::chrono::milliseconds(0);
 static std::mutex _m;
 
+// Reads /proc/stat and updates load of every cpu from the difference to the
+// previous sample. Caller holds _m.
+static bool read_sample() {
+
+	if ( stat_file == nullptr || !stat_file -> read())
+		return false;
+
+	std::string_view data = stat_file -> data();
+	std::string_view line;
+	size_t cores = 0;
+
+	while ( PROCFILE::getline(data, line)) {
+
+		if ( !line.starts_with("cpu"))
+			break; // cpu lines come first
+
+		std::string_view name = PROCFILE::word(line);
+		size_t idx = 0;
+
+		if ( name.size() > 3 ) {
+			std::string_view n = name.substr(3);
+			idx = PROCFILE::number(n) + 1;
+			cores = std::max(cores, idx);
+		}
+
+		// user nice system idle iowait irq softirq steal; guest time is
+		// already accounted in user and nice
+		uint64_t v[8] = { 0 };
+		for ( int i = 0; i < 8; i++ )
+			v[i] = PROCFILE::number(line);
+
+		uint64_t total = v[0] + v[1] + v[2] + v[3] + v[4] + v[5] + v[6] + v[7];
+		uint64_t busy = total - v[3] - v[4];
+
+		if ( idx >= sample.total.size()) {
+			sample.busy.resize(idx + 1, 0);
+			sample.total.resize(idx + 1, 0);
+			sample.load.resize(idx + 1, 0.0);
+		}
+
+		if ( sample.total[idx] != 0 && total > sample.total[idx] && busy >= sample.busy[idx] )
+			sample.load[idx] = std::clamp(100.0 * ( busy - sample.busy[idx] ) / ( total - sample.total[idx] ), 0.0, 100.0);
+
+		sample.busy[idx] = busy;
+		sample.total[idx] = total;
+	}
+
+	sample.cores = cores;
+	return true;
+}
+
 static expr::VARIABLE fn_cpuinfo(const expr::FUNCTION_ARGS& args) {
 
 	if ( cpu == nullptr ) {
@@ -86,7 +157,7 @@ static expr::VARIABLE fn_cpuinfo(const expr::FUNCTION_ARGS& args) {
 
 static expr::VARIABLE fn_cpuload(const expr::FUNCTION_ARGS& args) {
 
-	if ( cpu == nullptr ) {
+	if ( stat_file == nullptr ) {
 
 		logger::error["plugin"] << "cannot retrieve cpu load, cpu object is not available" << std::endl;
 		return "";
@@ -94,26 +165,20 @@ static expr::VARIABLE fn_cpuload(const expr::FUNCTION_ARGS& args) {
 
 	std::lock_guard<std::mutex> guard(_m);
 
+	if ( sample.load.empty())
+		return 0.0;
+
 	if ( !args.empty() && args[0].number_convertible().empty()) {
 
 		size_t i = (int)args[0].to_int();
-		if ( i < cpu -> size()) {
-
-			try {
-				return cpu -> operator[](i).load();
-
-			} catch ( const std::runtime_error& e ) {
-
-				logger::error["plugin"] << "failed to retrieve cpu load, reason: " << e.what() << std::endl;
-				return cpu -> load();
-			}
-
-		} else logger::error["plugin"] << "cannot retrieve cpu load for cpu" << args[0].to_int() << ", out of bounds, range is 0 - " << cpu -> size() << std::endl;
+		if ( i < sample.cores )
+			return sample.load[i + 1];
+		else logger::error["plugin"] << "cannot retrieve cpu load for cpu" << args[0].to_int() << ", out of bounds, range is 0 - " << sample.cores << std::endl;
 
 	} else if ( !args.empty())
 		logger::warning["plugin"] << "argument " << args[0].to_string() << " is not convertible to number, cpu::load function argument must be number" << std::endl;
 
-	return cpu -> load();
+	return sample.load[0];
 }
 
 int plugin::CPUINFO::interval() {
@@ -122,6 +187,8 @@ int plugin::CPUINFO::interval() {
 }
 
 
+// Takes one /proc/stat sample per interval; all cpu::load calls read it
+// until the next one.
 bool plugin::CPUINFO::update() {
 
 	if ( !_enabled || cpu == nullptr )
@@ -133,10 +200,16 @@ bool plugin::CPUINFO::update() {
 	if ( now < next )
 		return false;
 
+	this -> last_updated = now;
+
 	std::lock_guard<std::mutex> guard(_m);
-	cpu -> update();
 
-	return true;
+	if ( now >= info_updated + INFO_INTERVAL ) {
+		cpu -> update();
+		info_updated = now;
+	}
+
+	return read_sample();
 }
 
 plugin::CPUINFO::CPUINFO(CONFIG::MAP *cfg) {
@@ -150,7 +223,12 @@ plugin::CPUINFO::CPUINFO(CONFIG::MAP *cfg) {
 
 		try {
 			cpu = new cpu_t(4);
+			stat_file = new PROCFILE("/proc/stat", 16384);
 			this -> last_updated = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+			info_updated = this -> last_updated;
+
+			std::lock_guard<std::mutex> guard(_m);
+			read_sample();
 
 		} catch ( const std::runtime_error &e ) {
 
@@ -177,6 +255,14 @@ plugin::CPUINFO::~CPUINFO() {
 		cpu = nullptr;
 	}
 
+	if ( stat_file != nullptr ) {
+
+		delete stat_file;
+		stat_file = nullptr;
+	}
+
+	sample = CPU_SAMPLE();
+
 	CONFIG::functions.erase("cpu::info");
 	CONFIG::functions.erase("cpu::load");
 }
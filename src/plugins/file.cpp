@@ -1,11 +1,109 @@
 #include <fstream>
+#include <sstream>
 #include <filesystem>
+#include <mutex>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <sys/stat.h>
 
 #include "logger.hpp"
 #include "throws.hpp"
 #include "plugin.hpp"
+#include "display.hpp"
+#include "fs_funcs.hpp"
 #include "plugins/file.hpp"
 
+enum class FILE_STATE { OK, MISSING, UNREADABLE };
+
+// Parsed state of one file: contents, offsets of line starts and results of
+// readconf lookups. Valid for as long as the watcher generation or, for
+// unwatched files, the (inode, mtime, size) triple stays the same.
+struct FILE_CONTENT {
+	uint64_t generation = 0;
+	ino_t inode = 0;
+	int64_t mtime = -1;
+	int64_t size = -1;
+	bool cacheable = true;
+	FILE_STATE state = FILE_STATE::MISSING;
+	std::string content;
+	std::vector<size_t> lines;
+	std::unordered_map<std::string, std::string> conf;
+};
+
+static std::mutex _m;
+static std::map<std::string, FILE_CONTENT> _files;
+
+static void load_file(const std::string& filename, FILE_CONTENT& entry, const struct stat *st) {
+
+	entry.content.clear();
+	entry.lines.clear();
+	entry.conf.clear();
+
+	if ( st == nullptr ) {
+
+		entry.state = FILE_STATE::MISSING;
+		entry.inode = 0;
+		entry.mtime = -1;
+		entry.size = -1;
+		return;
+	}
+
+	entry.inode = st -> st_ino;
+	entry.mtime = (int64_t)st -> st_mtim.tv_sec * 1000000000LL + st -> st_mtim.tv_nsec;
+	entry.size = st -> st_size;
+
+	std::ifstream fd(filename, std::ios::binary);
+
+	if ( !fd.good()) {
+		entry.state = FILE_STATE::UNREADABLE;
+		return;
+	}
+
+	std::stringstream ss;
+	ss << fd.rdbuf();
+	entry.content = ss.str();
+	entry.state = FILE_STATE::OK;
+
+	if ( !entry.content.empty())
+		entry.lines.push_back(0);
+
+	for ( size_t i = 0; i < entry.content.size(); i++ )
+		if ( entry.content[i] == '\n' && i + 1 < entry.content.size())
+			entry.lines.push_back(i + 1);
+}
+
+// Returns parsed entry for filename, re-reading it only when it has changed.
+// Files followed by the watcher are re-read after a change event; other files
+// are validated with stat(). Files on proc/sysfs report neither events nor
+// reliable mtime/size and are read on every call. Caller holds _m.
+static FILE_CONTENT& file_entry(const std::string& filename) {
+
+	uint64_t generation = display != nullptr && display -> watcher != nullptr ?
+		display -> watcher -> subscribe(filename) : 0;
+
+	bool is_new = !_files.contains(filename);
+	FILE_CONTENT& entry = _files[filename];
+
+	if ( is_new )
+		entry.cacheable = !fs::is_pseudo(filename);
+	else if ( entry.cacheable && generation != 0 && entry.generation == generation )
+		return entry;
+
+	struct stat st;
+	bool exists = ::stat(filename.c_str(), &st) == 0;
+
+	if ( !is_new && entry.cacheable && generation == 0 && entry.generation == 0 &&
+		exists == ( entry.state != FILE_STATE::MISSING ) && ( !exists || (
+		st.st_ino == entry.inode && st.st_size == entry.size &&
+		(int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec == entry.mtime )))
+		return entry;
+
+	entry.generation = generation;
+	load_file(filename, entry, exists ? &st : nullptr);
+	return entry;
+}
+
 expr::VARIABLE plugin::FILE::fn_readline(const expr::FUNCTION_ARGS& args) {
 
         std::string filename = !args.empty() && args[0].string_convertible().empty()?
@@ -16,10 +114,6 @@ expr::VARIABLE plugin::FILE::fn_readline(const expr::FUNCTION_ARGS& args) {
 		logger::error["plugin"] << "readline needs filename as argument" << std::endl;
 		return "";
 
-	} else if ( !std::filesystem::exists(filename)) {
-
-		logger::error["plugin"] << "readline cannot open " << filename << " - file does not exist" << std::endl;
-		return "";
 	}
 
 	int line_no = 1;
@@ -42,24 +136,33 @@ expr::VARIABLE plugin::FILE::fn_readline(const expr::FUNCTION_ARGS& args) {
 		}
 	}
 
-	std::ifstream fd(filename);
-	if ( !fd.good()) {
+	std::lock_guard<std::mutex> lock(_m);
+	FILE_CONTENT& entry = file_entry(filename);
 
-		logger::error["plugin"] << "readline failed to open " << filename << " - file exists but is not readable, permission problem?" << std::endl;
-		if ( fd.is_open())
-			fd.close();
+	if ( entry.state == FILE_STATE::MISSING ) {
 
+		logger::error["plugin"] << "readline cannot open " << filename << " - file does not exist" << std::endl;
+		return "";
+
+	} else if ( entry.state == FILE_STATE::UNREADABLE ) {
+
+		logger::error["plugin"] << "readline failed to open " << filename << " - file exists but is not readable, permission problem?" << std::endl;
 		return "";
 	}
 
-	std::string str;
-	while ( line_no > 0 && std::getline(fd, str) )
-		line_no--;
+	if ( line_no < 1 )
+		return "";
+
+	if ((size_t)line_no > entry.lines.size()) {
 
-	if ( line_no > 0 )
 		logger::warning["plugin"] << "readline failed to parse line, file does not have enough lines" << std::endl;
+		return "";
+	}
+
+	size_t begin = entry.lines[line_no - 1];
+	size_t end = entry.content.find('\n', begin);
 
-	return str;
+	return entry.content.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
 }
 
 expr::VARIABLE plugin::FILE::fn_readconf(const expr::FUNCTION_ARGS& args) {
@@ -91,24 +194,25 @@ expr::VARIABLE plugin::FILE::fn_readconf(const expr::FUNCTION_ARGS& args) {
 
 	}
 
-	if ( !std::filesystem::exists(filename)) {
+	std::lock_guard<std::mutex> lock(_m);
+	FILE_CONTENT& entry = file_entry(filename);
+
+	if ( entry.state == FILE_STATE::MISSING ) {
 
 		logger::error["plugin"] << "readconf cannot open " << filename << " - file does not exist" << std::endl;
 		return fallback;
-	}
 
-	std::string value;
-
-	std::ifstream fd(filename);
-	if ( !fd.good()) {
+	} else if ( entry.state == FILE_STATE::UNREADABLE ) {
 
 		logger::error["plugin"] << "readconf failed to open " << filename << " - file exists but is not readable, permission problem?" << std::endl;
-		if ( fd.is_open())
-			fd.close();
-
 		return fallback;
 	}
 
+	if ( auto it = entry.conf.find(key); it != entry.conf.end())
+		return it -> second.empty() ? fallback : it -> second;
+
+	std::string value;
+	std::istringstream fd(entry.content);
 	std::string str;
 	while ( std::getline(fd, str)) {
 
@@ -124,7 +228,9 @@ expr::VARIABLE plugin::FILE::fn_readconf(const expr::FUNCTION_ARGS& args) {
 		}
 	}
 
-	fd.close();
+	if ( entry.cacheable )
+		entry.conf[key] = value;
+
 	return value.empty() ? fallback : value;
 }
 
@@ -1,44 +1,263 @@
 #include <filesystem>
+#include <map>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <condition_variable>
+#include <cerrno>
+#include <cctype>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
 
 #include "logger.hpp"
 #include "throws.hpp"
 #include "plugin.hpp"
+#include "procfile.hpp"
 #include "plugins/fs.hpp"
 
-expr::VARIABLE plugin::FS::fn_capacity(const expr::FUNCTION_ARGS& args) {
+// Last known result of stat()/statvfs() for one path. Results are produced by
+// short-lived worker threads so that a hung filesystem (dead NFS server,
+// unplugged USB disk) blocks only its worker and never the scheduler.
+struct FS_STAT {
+	bool valid = false;
+	bool pending = false;
+	bool hung = false;
+	int error = 0;
+	bool is_file = false;
+	uint64_t capacity = 0;
+	uint64_t free = 0;
+	uint64_t available = 0;
+	std::chrono::steady_clock::time_point started;
+};
+
+struct FS_MOUNT {
+	std::string mountpoint;
+	std::string device;
+	std::string type;
+};
+
+// Shared with detached workers through shared_ptr, so that a worker returning
+// from a hung call after the plugin is gone does not touch freed memory.
+struct FS_CACHE {
+	std::mutex m;
+	std::condition_variable_any cv;
+	std::map<std::string, std::shared_ptr<FS_STAT>> stats;
+	std::vector<FS_MOUNT> mounts;
+	std::chrono::milliseconds interval = std::chrono::milliseconds(5000);
+	std::chrono::milliseconds timeout = std::chrono::milliseconds(2000);
+	// set by configure() to start sampler's wait over with new interval
+	bool reconfigured = false;
+};
+
+// Pseudo and virtual filesystems left out of fs::list; they have no
+// meaningful capacity for a disk table.
+static const std::vector<std::string> IGNORED_FS_TYPES = {
+	"autofs", "binfmt_misc", "bpf", "cgroup", "cgroup2", "configfs", "debugfs",
+	"devpts", "devtmpfs", "efivarfs", "fusectl", "hugetlbfs", "mqueue", "nsfs",
+	"proc", "pstore", "ramfs", "rpc_pipefs", "securityfs", "sysfs", "tmpfs",
+	"tracefs", "squashfs", "overlay"
+};
+
+static std::shared_ptr<FS_CACHE> cache = nullptr;
+static PROCFILE *mountinfo = nullptr;
+static std::jthread sampler;
+
+// How long the first lookup of a new path waits for its result.
+static constexpr std::chrono::milliseconds FIRST_WAIT = std::chrono::milliseconds(100);
+
+// Starts a worker for path unless one is still in flight. Caller holds c -> m.
+static void sample(const std::shared_ptr<FS_CACHE>& c, const std::string& path, const std::shared_ptr<FS_STAT>& st) {
+
+	if ( st -> pending )
+		return;
+
+	st -> pending = true;
+	st -> started = std::chrono::steady_clock::now();
+
+	std::thread([c, path, st]() {
+
+		struct stat sb;
+		struct statvfs vfs;
+		bool is_file = false;
+		uint64_t capacity = 0, free = 0, available = 0;
+		int error = 0;
+
+		if ( ::stat(path.c_str(), &sb) != 0 )
+			error = errno;
+		else if ( S_ISREG(sb.st_mode)) {
+			is_file = true;
+			capacity = sb.st_size;
+		} else if ( !S_ISDIR(sb.st_mode))
+			error = ENOTDIR;
+		else if ( statvfs(path.c_str(), &vfs) != 0 )
+			error = errno;
+		else {
+			capacity = (uint64_t)vfs.f_blocks * vfs.f_frsize;
+			free = (uint64_t)vfs.f_bfree * vfs.f_frsize;
+			available = (uint64_t)vfs.f_bavail * vfs.f_frsize;
+		}
+
+		std::lock_guard<std::mutex> lock(c -> m);
+
+		if ( st -> hung )
+			logger::notice["plugin"] << "plugin fs: " << path << " is responding again" << std::endl;
+
+		st -> pending = false;
+		st -> hung = false;
+		st -> error = error;
+
+		// last known values stand in only for a path that does not answer;
+		// one that answers with an error (disk removed) has none
+		st -> valid = error == 0;
+
+		if ( error == 0 ) {
+			st -> is_file = is_file;
+			st -> capacity = capacity;
+			st -> free = free;
+			st -> available = available;
+		}
+
+		c -> cv.notify_all();
+
+	}).detach();
+}
+
+static void read_mounts(const std::shared_ptr<FS_CACHE>& c) {
+
+	if ( mountinfo == nullptr || !mountinfo -> read())
+		return;
+
+	std::vector<FS_MOUNT> mounts;
+	std::string_view data = mountinfo -> data();
+	std::string_view line;
+
+	// id parent major:minor root mountpoint options [optional fields] - type source super_options
+	while ( PROCFILE::getline(data, line)) {
+
+		FS_MOUNT mnt;
+
+		for ( int i = 0; i < 4; i++ )
+			PROCFILE::word(line);
+
+		std::string_view mountpoint = PROCFILE::word(line);
+
+		if ( auto pos = line.find(" - "); pos != std::string_view::npos )
+			line.remove_prefix(pos + 3);
+		else continue;
+
+		std::string_view type = PROCFILE::word(line);
+		std::string_view device = PROCFILE::word(line);
+
+		if ( mountpoint.empty() || std::find(IGNORED_FS_TYPES.begin(), IGNORED_FS_TYPES.end(), type) != IGNORED_FS_TYPES.end())
+			continue;
+
+		// mountinfo escapes blanks as octal, e.g. \040
+		for ( size_t i = 0; i < mountpoint.size(); i++ ) {
+
+			if ( mountpoint[i] == '\\' && i + 3 < mountpoint.size() &&
+				std::isdigit((unsigned char)mountpoint[i + 1])) {
+
+				mnt.mountpoint += (char)(( mountpoint[i + 1] - '0' ) * 64 + ( mountpoint[i + 2] - '0' ) * 8 + ( mountpoint[i + 3] - '0' ));
+				i += 3;
+
+			} else mnt.mountpoint += mountpoint[i];
+		}
+
+		mnt.device = device;
+		mnt.type = type;
+
+		// bind mounts and stacked mounts: latest mount on a mountpoint wins
+		std::erase_if(mounts, [&mnt](const FS_MOUNT& m) { return m.mountpoint == mnt.mountpoint; });
+		mounts.push_back(std::move(mnt));
+	}
+
+	std::lock_guard<std::mutex> lock(c -> m);
+	c -> mounts = std::move(mounts);
+}
+
+// Refreshes mount table and every path that has been asked for once per
+// interval, and reports workers that have been stuck for longer than timeout.
+static void sampler_loop(std::stop_token token, std::shared_ptr<FS_CACHE> c) {
+
+	while ( !token.stop_requested()) {
+
+		read_mounts(c);
+
+		std::unique_lock<std::mutex> lock(c -> m);
+
+		for ( auto& [path, st] : c -> stats ) {
+
+			if ( st -> pending && !st -> hung && std::chrono::steady_clock::now() - st -> started > c -> timeout ) {
+
+				st -> hung = true;
+				logger::warning["plugin"] << "plugin fs: " << path << " did not respond in " << c -> timeout.count() <<
+					"ms, using last known values" << std::endl;
+			}
+
+			sample(c, path, st);
+		}
+
+		c -> cv.wait_for(lock, token, c -> interval, [&c]() { return c -> reconfigured; });
+		c -> reconfigured = false;
+	}
+}
+
+static bool path_arg(const expr::FUNCTION_ARGS& args, std::string& path) {
 
 	if ( args.empty() || !args[0].is_string_convertible() || args[0].to_string().empty()) {
 
-		logger::error["plugin"] << "plugin fs needs path where filesystem is mounted or filename, " <<
-			( args.empty() ? "none provided" : ( !args[0].is_string_convertible() ? "argument is not string" : "argument is empty" )) <<
+		logger::error["plugin"] << "plugin fs needs path where filesystem is mounted, " <<
+			( args.empty() ? "argument not given" : ( !args[0].is_string_convertible() ? "argument is not string" : "argument is empty" )) <<
 			std::endl;
-		return (double)0;
+		return false;
 	}
 
-	std::string path = args[0].to_string();
-	std::error_code ec;
+	path = args[0].to_string();
+	return true;
+}
 
-	if ( !std::filesystem::exists(path) || ( !std::filesystem::is_directory(path) && !std::filesystem::is_regular_file(path))) {
+// Returns cached result for path. A path seen for the first time is
+// registered with the sampler and given a brief moment to produce a result.
+static bool lookup(const std::string& path, FS_STAT& result) {
 
-		logger::error["plugin"] << "path provided for plugin fs, does not exist and is not directory or regular file" << std::endl;
-		return (double)0;
-	}
+	if ( cache == nullptr )
+		return false;
 
-	if ( std::filesystem::is_regular_file(path)) {
+	std::unique_lock<std::mutex> lock(cache -> m);
+	std::shared_ptr<FS_STAT> st;
 
-		if ( const std::uintmax_t size = std::filesystem::file_size(path, ec); ec ) {
+	if ( auto it = cache -> stats.find(path); it != cache -> stats.end())
+		st = it -> second;
+	else {
 
-			logger::error["plugin"] << "plugin fs cannot retrieve size for " << path << ", reason: " << ec.message() << std::endl;
-			return (double)0;
+		st = std::make_shared<FS_STAT>();
+		cache -> stats[path] = st;
+		sample(cache, path, st);
+		cache -> cv.wait_for(lock, FIRST_WAIT, [&st]() { return !st -> pending; });
+	}
+
+	if ( !st -> valid ) {
 
-		} else return (double)size;
+		if ( !st -> pending && st -> error != 0 )
+			logger::error["plugin"] << "plugin fs cannot retrieve space info for " << path << ", reason: " <<
+				std::strerror(st -> error) << std::endl;
+		return false;
 	}
 
-	if ( const std::filesystem::space_info si = std::filesystem::space(path, ec); ec ) {
+	result = *st;
+	return true;
+}
+
+expr::VARIABLE plugin::FS::fn_capacity(const expr::FUNCTION_ARGS& args) {
+
+	std::string path;
+	FS_STAT st;
 
-		logger::error["plugin"] << "plugin fs cannot retrieve space info for " << path << ", reason: " << ec.message() << std::endl;
+	if ( !path_arg(args, path) || !lookup(path, st))
 		return (double)0;
-	} else return (double)si.capacity;
+
+	return (double)st.capacity;
 }
 
 expr::VARIABLE plugin::FS::fn_capacity_pretty(const expr::FUNCTION_ARGS& args) {
@@ -48,29 +267,19 @@ expr::VARIABLE plugin::FS::fn_capacity_pretty(const expr::FUNCTION_ARGS& args) {
 
 expr::VARIABLE plugin::FS::fn_used(const expr::FUNCTION_ARGS& args) {
 
-	if ( args.empty() || !args[0].is_string_convertible() || args[0].to_string().empty()) {
+	std::string path;
+	FS_STAT st;
 
-		logger::error["plugin"] << "plugin fs needs path where filesystem is mounted, " <<
-			( args.empty() ? "argument not given" : ( !args[0].is_string_convertible() ? "argument is not string" : "argument is empty" )) <<
-			std::endl;
+	if ( !path_arg(args, path) || !lookup(path, st))
 		return (double)0;
-	}
 
-	std::string path = args[0].to_string();
-	std::error_code ec;
-
-	if ( !std::filesystem::exists(path) || !std::filesystem::is_directory(path)) {
+	if ( st.is_file ) {
 
 		logger::error["plugin"] << "path provided for plugin fs, does not exist or is not directory" << std::endl;
 		return (double)0;
 	}
 
-	if ( const std::filesystem::space_info si = std::filesystem::space(path, ec); ec ) {
-
-		logger::error["plugin"] << "plugin fs cannot retrieve space info for " << path << ", reason: " << ec.message() << std::endl;
-		return (double)0;
-
-	} else return (double)(si.capacity - si.free);
+	return (double)(st.capacity - st.free);
 }
 
 expr::VARIABLE plugin::FS::fn_used_pretty(const expr::FUNCTION_ARGS& args) {
@@ -80,29 +289,19 @@ expr::VARIABLE plugin::FS::fn_used_pretty(const expr::FUNCTION_ARGS& args) {
 
 expr::VARIABLE plugin::FS::fn_free(const expr::FUNCTION_ARGS& args) {
 
-	if ( args.empty() || !args[0].is_string_convertible() || args[0].to_string().empty()) {
+	std::string path;
+	FS_STAT st;
 
-		logger::error["plugin"] << "plugin fs needs path where filesystem is mounted, " <<
-			( args.empty() ? "argument not given" : ( !args[0].is_string_convertible() ? "argument is not string" : "argument is empty" )) <<
-			std::endl;
+	if ( !path_arg(args, path) || !lookup(path, st))
 		return (double)0;
-	}
-
-	std::string path = args[0].to_string();
-	std::error_code ec;
 
-	if ( !std::filesystem::exists(path) || !std::filesystem::is_directory(path)) {
+	if ( st.is_file ) {
 
 		logger::error["plugin"] << "path provided for plugin fs, does not exist or is not directory" << std::endl;
 		return (double)0;
 	}
 
-	if ( const std::filesystem::space_info si = std::filesystem::space(path, ec); ec ) {
-
-		logger::error["plugin"] << "plugin fs cannot retrieve space info for " << path << ", reason: " << ec.message() << std::endl;
-		return (double)0;
-
-	} else return (double)si.free;
+	return (double)st.free;
 }
 
 expr::VARIABLE plugin::FS::fn_free_pretty(const expr::FUNCTION_ARGS& args) {
@@ -112,40 +311,135 @@ expr::VARIABLE plugin::FS::fn_free_pretty(const expr::FUNCTION_ARGS& args) {
 
 expr::VARIABLE plugin::FS::fn_available(const expr::FUNCTION_ARGS& args) {
 
-	if ( args.empty() || !args[0].is_string_convertible() || args[0].to_string().empty()) {
+	std::string path;
+	FS_STAT st;
 
-		logger::error["plugin"] << "plugin fs needs path where filesystem is mounted, " <<
-			( args.empty() ? "argument not given" : ( !args[0].is_string_convertible() ? "argument is not string" : "argument is empty" )) <<
-			std::endl;
+	if ( !path_arg(args, path) || !lookup(path, st))
 		return (double)0;
-	}
-
-	std::string path = args[0].to_string();
-	std::error_code ec;
 
-	if ( !std::filesystem::exists(path) || !std::filesystem::is_directory(path)) {
+	if ( st.is_file ) {
 
 		logger::error["plugin"] << "path provided for plugin fs, does not exist or is not directory" << std::endl;
 		return (double)0;
 	}
 
-	if ( const std::filesystem::space_info si = std::filesystem::space(path, ec); ec ) {
+	return (double)st.available;
+}
+
+expr::VARIABLE plugin::FS::fn_available_pretty(const expr::FUNCTION_ARGS& args) {
+
+	return common::HumanReadable(plugin::FS::fn_available(args).to_double());
+}
+
+static bool mount_arg(const expr::FUNCTION_ARGS& args, const std::string& fn, FS_MOUNT& mnt) {
+
+	if ( args.empty() || !args[0].number_convertible().empty()) {
 
-		logger::error["plugin"] << "plugin fs cannot retrieve space info for " << path << ", reason: " << ec.message() << std::endl;
+		logger::error["plugin"] << fn << " needs index of mount as argument" << std::endl;
+		return false;
+	}
+
+	if ( cache == nullptr )
+		return false;
+
+	int idx = args[0].to_int();
+	std::lock_guard<std::mutex> lock(cache -> m);
+
+	if ( idx < 0 || (size_t)idx >= cache -> mounts.size())
+		return false;
+
+	mnt = cache -> mounts[idx];
+	return true;
+}
+
+expr::VARIABLE plugin::FS::fn_count(const expr::FUNCTION_ARGS& args) {
+
+	if ( cache == nullptr )
 		return (double)0;
 
-	} else return (double)si.available;
+	std::lock_guard<std::mutex> lock(cache -> m);
+	return (double)cache -> mounts.size();
 }
 
-expr::VARIABLE plugin::FS::fn_available_pretty(const expr::FUNCTION_ARGS& args) {
+expr::VARIABLE plugin::FS::fn_list(const expr::FUNCTION_ARGS& args) {
 
-	return common::HumanReadable(plugin::FS::fn_available(args).to_double());
+	std::string separator = !args.empty() && args[0].string_convertible().empty() ? args[0].to_string() : ", ";
+	std::string res;
+
+	if ( cache == nullptr )
+		return res;
+
+	std::lock_guard<std::mutex> lock(cache -> m);
+
+	for ( const FS_MOUNT& mnt : cache -> mounts )
+		res += ( res.empty() ? "" : separator ) + mnt.mountpoint;
+
+	return res;
+}
+
+expr::VARIABLE plugin::FS::fn_mount(const expr::FUNCTION_ARGS& args) {
+
+	FS_MOUNT mnt;
+	return mount_arg(args, "fs::mount", mnt) ? mnt.mountpoint : "";
+}
+
+expr::VARIABLE plugin::FS::fn_device(const expr::FUNCTION_ARGS& args) {
+
+	FS_MOUNT mnt;
+	return mount_arg(args, "fs::device", mnt) ? mnt.device : "";
+}
+
+expr::VARIABLE plugin::FS::fn_type(const expr::FUNCTION_ARGS& args) {
+
+	FS_MOUNT mnt;
+	return mount_arg(args, "fs::type", mnt) ? mnt.type : "";
+}
+
+void plugin::FS::configure(CONFIG::MAP *cfg) {
+
+	if ( cfg == nullptr || cache == nullptr )
+		return;
+
+	for ( auto& [k, v] : *cfg ) {
+
+		if ( k == "class" || k == "type" )
+			continue;
+		else if (( k != "interval" && k != "timeout" ) || !std::holds_alternative<std::string>(v)) {
+
+			logger::warning["plugin"] << "fs: unknown option '" << k << "', ignored" << std::endl;
+			continue;
+		}
+
+		int i;
+
+		if ( !CONFIG::evaluate_int("plugin fs", k, std::get<std::string>(v), i) || i < 100 ) {
+
+			logger::warning["plugin"] << "fs: " << k << " must be a number of milliseconds, at least 100" << std::endl;
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(cache -> m);
+
+		if ( k == "interval" )
+			cache -> interval = std::chrono::milliseconds(i);
+		else cache -> timeout = std::chrono::milliseconds(i);
+
+		cache -> reconfigured = true;
+		cache -> cv.notify_all();
+	}
 }
 
 plugin::FS::FS(CONFIG::MAP *cfg) {
 
 	logger::vverbose["plugin"] << "initializing plugin fs" << std::endl;
 
+	cache = std::make_shared<FS_CACHE>();
+	mountinfo = new PROCFILE("/proc/self/mountinfo");
+	read_mounts(cache);
+	plugin::FS::configure(cfg);
+
+	sampler = std::jthread(sampler_loop, cache);
+
 	CONFIG::functions.append({ "fs::size", plugin::FS::fn_capacity });
 	CONFIG::functions.append({ "fs::capacity", plugin::FS::fn_capacity });
 	CONFIG::functions.append({ "fs::used", plugin::FS::fn_used });
@@ -157,10 +451,28 @@ plugin::FS::FS(CONFIG::MAP *cfg) {
 	CONFIG::functions.append({ "fs::used::hr", plugin::FS::fn_used_pretty });
 	CONFIG::functions.append({ "fs::free::hr", plugin::FS::fn_free_pretty });
 	CONFIG::functions.append({ "fs::available::hr", plugin::FS::fn_available_pretty });
+
+	CONFIG::functions.append({ "fs::count", plugin::FS::fn_count });
+	CONFIG::functions.append({ "fs::list", plugin::FS::fn_list });
+	CONFIG::functions.append({ "fs::mount", plugin::FS::fn_mount });
+	CONFIG::functions.append({ "fs::device", plugin::FS::fn_device });
+	CONFIG::functions.append({ "fs::type", plugin::FS::fn_type });
 }
 
 plugin::FS::~FS() {
 
+	if ( sampler.joinable()) {
+		sampler.request_stop();
+		sampler.join();
+	}
+
+	if ( mountinfo != nullptr ) {
+		delete mountinfo;
+		mountinfo = nullptr;
+	}
+
+	cache = nullptr;
+
         CONFIG::functions.erase("fs::size");
 	CONFIG::functions.erase("fs::capacity");
 	CONFIG::functions.erase("fs::used");
@@ -172,4 +484,10 @@ plugin::FS::~FS() {
 	CONFIG::functions.erase("fs::used::hr");
 	CONFIG::functions.erase("fs::free::hr");
 	CONFIG::functions.erase("fs::available::hr");
+
+	CONFIG::functions.erase("fs::count");
+	CONFIG::functions.erase("fs::list");
+	CONFIG::functions.erase("fs::mount");
+	CONFIG::functions.erase("fs::device");
+	CONFIG::functions.erase("fs::type");
 }
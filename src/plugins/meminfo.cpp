@@ -1,69 +1,77 @@
 #include <cstdint>
 #include <algorithm>
+#include <chrono>
+#include <mutex>
 
 #include "logger.hpp"
 #include "throws.hpp"
 #include "plugin.hpp"
-#include "mem.hpp"
+#include "procfile.hpp"
 #include "plugins/meminfo.hpp"
 
-static mem_t* meminfo = nullptr;
+enum class MEM_UNIT { KB, MB, GB, PERCENT };
 
-expr::VARIABLE plugin::MEMINFO::fn_meminfo_ram_total(const expr::FUNCTION_ARGS& args) {
+// One coherent reading of /proc/meminfo, values in kB
+struct MEM_SAMPLE {
+	uint64_t ram_total = 0;
+	uint64_t ram_free = 0;
+	uint64_t swap_total = 0;
+	uint64_t swap_free = 0;
+};
 
-	mem_t::type t = mem_t::mb;
+static PROCFILE *meminfo = nullptr;
+static MEM_SAMPLE sample;
+static bool sampled = false;
+static std::mutex _m;
 
-	if ( args.empty())
-		logger::warning["plugin"] << "meminfo requires 1 argument, one of following strings: kb, mb, gb or percent" << std::endl;
+// Parses /proc/meminfo into sample. Free RAM is MemAvailable, the kernel's
+// estimate of memory available without swapping; kernels without it fall
+// back to MemFree + Buffers + Cached. Caller holds _m.
+static bool read_sample() {
 
-	else {
+	if ( meminfo == nullptr || !meminfo -> read())
+		return false;
 
-		std::string s = args[0].string_convertible().empty() ? args[0].to_string() : "";
-		s = common::to_lower(common::trim_ws(common::unquoted(common::trim_ws(s))));
+	MEM_SAMPLE s;
+	uint64_t mem_free = 0, buffers = 0, cached = 0;
+	bool has_available = false;
 
-		if ( s == "kb" ) t = mem_t::kb;
-		else if ( s == "mb" ) t = mem_t::mb;
-		else if ( s == "gb" ) t = mem_t::gb;
-		else if ( s == "%" || s.starts_with("p")) t = mem_t::percent;
-		else if ( s.empty()) logger::error["plugin"] << "meminfo failure, called with empty argument" << std::endl;
-		else logger::error["plugin"] << "meminfo failure, argument '" << s << "' not any of kb, mb, gb or percent" << std::endl;
-	}
+	std::string_view data = meminfo -> data();
+	std::string_view line;
 
-	meminfo -> update();
-	double v = meminfo -> ram.total[t];
-	if ( t == mem_t::percent ) v = std::clamp(v, 0.0, 100.0);
-	return v;
-}
+	while ( PROCFILE::getline(data, line)) {
 
-expr::VARIABLE plugin::MEMINFO::fn_meminfo_ram_used(const expr::FUNCTION_ARGS& args) {
+		size_t pos = line.find(':');
 
-	mem_t::type t = mem_t::mb;
+		if ( pos == std::string_view::npos )
+			continue;
 
-	if ( args.empty())
-		logger::warning["plugin"] << "meminfo requires 1 argument, one of following strings: kb, mb, gb or percent" << std::endl;
+		std::string_view key = line.substr(0, pos);
+		std::string_view value = line.substr(pos + 1);
 
-	else {
+		if ( key == "MemTotal" ) s.ram_total = PROCFILE::number(value);
+		else if ( key == "MemFree" ) mem_free = PROCFILE::number(value);
+		else if ( key == "MemAvailable" ) { s.ram_free = PROCFILE::number(value); has_available = true; }
+		else if ( key == "Buffers" ) buffers = PROCFILE::number(value);
+		else if ( key == "Cached" ) cached = PROCFILE::number(value);
+		else if ( key == "SwapTotal" ) s.swap_total = PROCFILE::number(value);
+		else if ( key == "SwapFree" ) s.swap_free = PROCFILE::number(value);
+	}
 
-		std::string s = args[0].string_convertible().empty() ? args[0].to_string() : "";
-		s = common::to_lower(common::trim_ws(common::unquoted(common::trim_ws(s))));
+	if ( !has_available )
+		s.ram_free = mem_free + buffers + cached;
 
-		if ( s == "kb" ) t = mem_t::kb;
-		else if ( s == "mb" ) t = mem_t::mb;
-		else if ( s == "gb" ) t = mem_t::gb;
-		else if ( s == "%" || s.starts_with("p")) t = mem_t::percent;
-		else if ( s.empty()) logger::error["plugin"] << "meminfo failure, called with empty argument" << std::endl;
-		else logger::error["plugin"] << "meminfo failure, argument '" << s << "' not any of kb, mb, gb or percent" << std::endl;
-	}
+	s.ram_free = std::min(s.ram_free, s.ram_total);
+	s.swap_free = std::min(s.swap_free, s.swap_total);
 
-	meminfo -> update();
-	double v = meminfo -> ram.used[t];
-	if ( t == mem_t::percent ) v = std::clamp(v, 0.0, 100.0);
-	return v;
+	sample = s;
+	sampled = true;
+	return true;
 }
 
-expr::VARIABLE plugin::MEMINFO::fn_meminfo_ram_free(const expr::FUNCTION_ARGS& args) {
+static MEM_UNIT parse_unit(const expr::FUNCTION_ARGS& args) {
 
-	mem_t::type t = mem_t::mb;
+	MEM_UNIT t = MEM_UNIT::MB;
 
 	if ( args.empty())
 		logger::warning["plugin"] << "meminfo requires 1 argument, one of following strings: kb, mb, gb or percent" << std::endl;
@@ -73,96 +81,93 @@ expr::VARIABLE plugin::MEMINFO::fn_meminfo_ram_free(const expr::FUNCTION_ARGS& a
 		std::string s = args[0].string_convertible().empty() ? args[0].to_string() : "";
 		s = common::to_lower(common::trim_ws(common::unquoted(common::trim_ws(s))));
 
-		if ( s == "kb" ) t = mem_t::kb;
-		else if ( s == "mb" ) t = mem_t::mb;
-		else if ( s == "gb" ) t = mem_t::gb;
-		else if ( s == "%" || s.starts_with("p")) t = mem_t::percent;
+		if ( s == "kb" ) t = MEM_UNIT::KB;
+		else if ( s == "mb" ) t = MEM_UNIT::MB;
+		else if ( s == "gb" ) t = MEM_UNIT::GB;
+		else if ( s == "%" || s.starts_with("p")) t = MEM_UNIT::PERCENT;
 		else if ( s.empty()) logger::error["plugin"] << "meminfo failure, called with empty argument" << std::endl;
 		else logger::error["plugin"] << "meminfo failure, argument '" << s << "' not any of kb, mb, gb or percent" << std::endl;
 	}
 
-	meminfo -> update();
-	double v = meminfo -> ram.free[t];
-	if ( t == mem_t::percent ) v = std::clamp(v, 0.0, 100.0);
-	return v;
+	return t;
 }
 
-expr::VARIABLE plugin::MEMINFO::fn_meminfo_swap_total(const expr::FUNCTION_ARGS& args) {
-
-	mem_t::type t = mem_t::mb;
+// Returns field(sample) of current sample converted to unit; percentages
+// are relative to total.
+template<typename F>
+static double value(const expr::FUNCTION_ARGS& args, F field, uint64_t MEM_SAMPLE::*total) {
 
-	if ( args.empty())
-		logger::warning["plugin"] << "meminfo requires 1 argument, one of following strings: kb, mb, gb or percent" << std::endl;
+	MEM_UNIT t = parse_unit(args);
+	std::lock_guard<std::mutex> lock(_m);
 
-	else {
+	if ( !sampled )
+		read_sample();
 
-		std::string s = args[0].string_convertible().empty() ? args[0].to_string() : "";
-		s = common::to_lower(common::trim_ws(common::unquoted(common::trim_ws(s))));
+	double kb = field(sample);
 
-		if ( s == "kb" ) t = mem_t::kb;
-		else if ( s == "mb" ) t = mem_t::mb;
-		else if ( s == "gb" ) t = mem_t::gb;
-		else if ( s == "%" || s.starts_with("p")) t = mem_t::percent;
-		else if ( s.empty()) logger::error["plugin"] << "meminfo failure, called with empty argument" << std::endl;
-		else logger::error["plugin"] << "meminfo failure, argument '" << s << "' not any of kb, mb, gb or percent" << std::endl;
+	switch ( t ) {
+		case MEM_UNIT::KB: return kb;
+		case MEM_UNIT::MB: return kb / 1024.0;
+		case MEM_UNIT::GB: return kb / ( 1024.0 * 1024.0 );
+		case MEM_UNIT::PERCENT:
+			return sample.*total == 0 ? 0.0 : std::clamp(kb * 100.0 / sample.*total, 0.0, 100.0);
 	}
 
-	meminfo -> update();
-	double v = meminfo -> swap.total[t];
-	if ( t == mem_t::percent ) v = std::clamp(v, 0.0, 100.0);
-	return v;
+	return kb;
 }
 
-expr::VARIABLE plugin::MEMINFO::fn_meminfo_swap_used(const expr::FUNCTION_ARGS& args) {
+expr::VARIABLE plugin::MEMINFO::fn_meminfo_ram_total(const expr::FUNCTION_ARGS& args) {
 
-	mem_t::type t = mem_t::mb;
+	return value(args, [](const MEM_SAMPLE& s) { return s.ram_total; }, &MEM_SAMPLE::ram_total);
+}
 
-	if ( args.empty())
-		logger::warning["plugin"] << "meminfo requires 1 argument, one of following strings: kb, mb, gb or percent" << std::endl;
+expr::VARIABLE plugin::MEMINFO::fn_meminfo_ram_used(const expr::FUNCTION_ARGS& args) {
 
-	else {
+	return value(args, [](const MEM_SAMPLE& s) { return s.ram_total - s.ram_free; }, &MEM_SAMPLE::ram_total);
+}
 
-		std::string s = args[0].string_convertible().empty() ? args[0].to_string() : "";
-		s = common::to_lower(common::trim_ws(common::unquoted(common::trim_ws(s))));
+expr::VARIABLE plugin::MEMINFO::fn_meminfo_ram_free(const expr::FUNCTION_ARGS& args) {
 
-		if ( s == "kb" ) t = mem_t::kb;
-		else if ( s == "mb" ) t = mem_t::mb;
-		else if ( s == "gb" ) t = mem_t::gb;
-		else if ( s == "%" || s.starts_with("p")) t = mem_t::percent;
-		else if ( s.empty()) logger::error["plugin"] << "meminfo failure, called with empty argument" << std::endl;
-		else logger::error["plugin"] << "meminfo failure, argument '" << s << "' not any of kb, mb, gb or percent" << std::endl;
-	}
+	return value(args, [](const MEM_SAMPLE& s) { return s.ram_free; }, &MEM_SAMPLE::ram_total);
+}
+
+expr::VARIABLE plugin::MEMINFO::fn_meminfo_swap_total(const expr::FUNCTION_ARGS& args) {
+
+	return value(args, [](const MEM_SAMPLE& s) { return s.swap_total; }, &MEM_SAMPLE::swap_total);
+}
 
-	meminfo -> update();
-	double v = meminfo -> swap.used[t];
-	if ( t == mem_t::percent ) v = std::clamp(v, 0.0, 100.0);
-	return v;
+expr::VARIABLE plugin::MEMINFO::fn_meminfo_swap_used(const expr::FUNCTION_ARGS& args) {
+
+	return value(args, [](const MEM_SAMPLE& s) { return s.swap_total - s.swap_free; }, &MEM_SAMPLE::swap_total);
 }
 
 expr::VARIABLE plugin::MEMINFO::fn_meminfo_swap_free(const expr::FUNCTION_ARGS& args) {
 
-	mem_t::type t = mem_t::mb;
+	return value(args, [](const MEM_SAMPLE& s) { return s.swap_free; }, &MEM_SAMPLE::swap_total);
+}
 
-	if ( args.empty())
-		logger::warning["plugin"] << "meminfo requires 1 argument, one of following strings: kb, mb, gb or percent" << std::endl;
+int plugin::MEMINFO::interval() {
 
-	else {
+	return 1000;
+}
 
-		std::string s = args[0].string_convertible().empty() ? args[0].to_string() : "";
-		s = common::to_lower(common::trim_ws(common::unquoted(common::trim_ws(s))));
+// Takes the sample all mem:: functions read until the next interval, so
+// every expression on a frame sees the same, consistent values.
+bool plugin::MEMINFO::update() {
 
-		if ( s == "kb" ) t = mem_t::kb;
-		else if ( s == "mb" ) t = mem_t::mb;
-		else if ( s == "gb" ) t = mem_t::gb;
-		else if ( s == "%" || s.starts_with("p")) t = mem_t::percent;
-		else if ( s.empty()) logger::error["plugin"] << "meminfo failure, called with empty argument" << std::endl;
-		else logger::error["plugin"] << "meminfo failure, argument '" << s << "' not any of kb, mb, gb or percent" << std::endl;
-	}
+	if ( !_enabled || meminfo == nullptr )
+		return false;
 
-	meminfo -> update();
-	double v = meminfo -> swap.free[t];
-	if ( t == mem_t::percent ) v = std::clamp(v, 0.0, 100.0);
-	return v;
+	std::chrono::milliseconds next = this -> last_updated + std::chrono::milliseconds(this -> interval());
+	std::chrono::milliseconds now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+
+	if ( now < next )
+		return false;
+
+	this -> last_updated = now;
+
+	std::lock_guard<std::mutex> lock(_m);
+	return read_sample();
 }
 
 plugin::MEMINFO::MEMINFO(CONFIG::MAP *cfg) {
@@ -172,7 +177,9 @@ plugin::MEMINFO::MEMINFO(CONFIG::MAP *cfg) {
 
 	logger::vverbose["plugin"] << "initializing plugin meminfo" << std::endl;
 
-	meminfo = new mem_t;
+	meminfo = new PROCFILE("/proc/meminfo");
+	sampled = false;
+
 	CONFIG::functions.append({ "mem::total", plugin::MEMINFO::fn_meminfo_ram_total });
 	CONFIG::functions.append({ "mem::used", plugin::MEMINFO::fn_meminfo_ram_used });
 	CONFIG::functions.append({ "mem::free", plugin::MEMINFO::fn_meminfo_ram_free });
@@ -0,0 +1,119 @@
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "logger.hpp"
+#include "procfile.hpp"
+
+PROCFILE::PROCFILE(const std::string& path, size_t size) : _path(path) {
+
+	this -> _buf.resize(size < 256 ? 256 : size);
+
+	if ( this -> _fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC); this -> _fd < 0 )
+		logger::error["plugin"] << "failed to open " << path << ": " << std::strerror(errno) << std::endl;
+}
+
+PROCFILE::~PROCFILE() {
+
+	if ( this -> _fd >= 0 )
+		::close(this -> _fd);
+
+	this -> _fd = -1;
+}
+
+bool PROCFILE::is_open() const {
+	return this -> _fd >= 0;
+}
+
+const std::string& PROCFILE::path() const {
+	return this -> _path;
+}
+
+std::string_view PROCFILE::data() const {
+	return std::string_view(this -> _buf.data(), this -> _len);
+}
+
+// Reads whole file from offset 0. proc files are generated in one go on read,
+// so a single pread that does not fill the buffer is a complete and coherent
+// snapshot; when it fills the buffer, the buffer is doubled and read retried.
+bool PROCFILE::read() {
+
+	if ( this -> _fd < 0 ) {
+
+		if ( this -> _fd = ::open(this -> _path.c_str(), O_RDONLY | O_CLOEXEC); this -> _fd < 0 ) {
+			this -> _len = 0;
+			return false;
+		}
+	}
+
+	while ( true ) {
+
+		ssize_t n = ::pread(this -> _fd, this -> _buf.data(), this -> _buf.size(), 0);
+
+		if ( n < 0 && errno == EINTR )
+			continue;
+		else if ( n < 0 ) {
+
+			logger::error["plugin"] << "failed to read " << this -> _path << ": " << std::strerror(errno) << std::endl;
+			this -> _len = 0;
+			return false;
+
+		} else if ((size_t)n == this -> _buf.size()) {
+
+			this -> _buf.resize(this -> _buf.size() * 2);
+			continue;
+		}
+
+		this -> _len = n;
+		return true;
+	}
+}
+
+bool PROCFILE::getline(std::string_view& data, std::string_view& line) {
+
+	if ( data.empty())
+		return false;
+
+	size_t pos = data.find('\n');
+
+	if ( pos == std::string_view::npos ) {
+		line = data;
+		data = std::string_view();
+	} else {
+		line = data.substr(0, pos);
+		data.remove_prefix(pos + 1);
+	}
+
+	return true;
+}
+
+uint64_t PROCFILE::number(std::string_view& s) {
+
+	uint64_t v = 0;
+
+	while ( !s.empty() && ( s.front() == ' ' || s.front() == '\t' ))
+		s.remove_prefix(1);
+
+	while ( !s.empty() && s.front() >= '0' && s.front() <= '9' ) {
+		v = v * 10 + ( s.front() - '0' );
+		s.remove_prefix(1);
+	}
+
+	return v;
+}
+
+std::string_view PROCFILE::word(std::string_view& s) {
+
+	while ( !s.empty() && ( s.front() == ' ' || s.front() == '\t' ))
+		s.remove_prefix(1);
+
+	size_t len = 0;
+
+	while ( len < s.size() && s[len] != ' ' && s[len] != '\t' )
+		len++;
+
+	std::string_view w = s.substr(0, len);
+	s.remove_prefix(len);
+	return w;
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cstring>
 #include <gd.h>
 #include "rgb.hpp"
 
@@ -12,13 +14,6 @@ RGBA::Raw RGBA::GREEN({ .R = 0x00, .G = 0xff, .B = 0x00, .A = 0xff });
 RGBA::Raw RGBA::BLUE({ .R = 0x00, .G = 0x00, .B = 0xff, .A = 0xff });
 RGBA::Raw RGBA::TRANSPARENT({ .R = 0x00, .G = 0x00, .B = 0x00, .A = 0x00 });
 
-RGBA::RGBA() noexcept {
-	this -> R = 0;
-	this -> G = 0;
-	this -> B = 0;
-	this -> A = 0xff;
-}
-
 // Returns true if the string is a valid hex color: 3, 4, 6, or 8 hex digits,
 // optionally prefixed with '#'. Accepts both upper- and lower-case A-F.
 bool RGBA::check_color(const std::string& hex) {
@@ -74,26 +69,41 @@ const std::string RGBA::hex_normalizer(const std::string& hex) {
 	return out;
 }
 
-RGBA::RGBA(int gdTrueColorPixel, bool inverted, double alpha) {
+// gd alpha is 0 (opaque) to 127 (transparent).
+void RGBA::from_gd(gdImageStruct *image, std::vector<RGBA>& bitmap, bool inverted, double opacity) {
+
+	bitmap.resize(image -> sx * image -> sy);
+	RGBA *p = bitmap.data();
 
-	this -> R = inverted ? ( 255 - gdTrueColorGetRed(gdTrueColorPixel)) : gdTrueColorGetRed(gdTrueColorPixel);
-	this -> G = inverted ? ( 255 - gdTrueColorGetGreen(gdTrueColorPixel)) : gdTrueColorGetGreen(gdTrueColorPixel);
-	this -> B = inverted ? ( 255 - gdTrueColorGetBlue(gdTrueColorPixel)) : gdTrueColorGetBlue(gdTrueColorPixel);
+	for ( int y = 0; y < image -> sy; y++ ) {
+		for ( int x = 0; x < image -> sx; x++, p++ ) {
 
-	unsigned char gdAlpha = gdTrueColorGetAlpha(gdTrueColorPixel);
-	gdAlpha = gdAlpha == 127 ? 0 : ( 255 - ( 2 * gdAlpha ));
+			int c = gdImageGetTrueColorPixel(image, x, y);
+			int a = gdTrueColorGetAlpha(c);
 
-	if ( alpha < 1.0 && alpha >= 0 ) {
-		double _a = (( 255 * 0.01 ) * ( alpha * 100));
-		if ( _a < 0 ) _a = 0;
-		else if ( _a > 255 ) _a = 255;
-		_a = 255 - _a;
-		unsigned char a = (unsigned char)_a;
-		if ( gdAlpha - a < 0 ) gdAlpha = 0;
-		else gdAlpha-=a;
+			*p = RGBA(gdTrueColorGetRed(c), gdTrueColorGetGreen(c), gdTrueColorGetBlue(c),
+				a == 127 ? 0 : 255 - ( 2 * a ));
+		}
 	}
 
-	this -> A = gdAlpha;
+	RGBA::finish(bitmap, inverted, opacity);
+}
+
+// Opacity below 1.0 lowers alpha of every pixel by the same amount, it does
+// not scale it.
+void RGBA::finish(std::span<RGBA> bitmap, bool inverted, double opacity) {
+
+	unsigned char invert = inverted ? 0xff : 0x00;
+	int sub = 0;
+
+	if ( opacity < 1.0 && opacity >= 0 )
+		sub = (int)( 255 - opacity * 255 );
+
+	for ( RGBA& p : bitmap ) {
+
+		unsigned char a = p.A > sub ? p.A - sub : 0;
+		p = RGBA(RGBA::mul(p.R ^ invert, a), RGBA::mul(p.G ^ invert, a), RGBA::mul(p.B ^ invert, a), a);
+	}
 }
 
 RGBA::RGBA(const std::string& hex, bool forced) {
@@ -127,49 +137,57 @@ RGBA::RGBA(const std::string& hex, bool forced) {
 	}
 }
 
-bool RGBA::operator ==(const RGBA& other) {
-
-	return this -> R == other.R && this -> G == other.G &&
-		this -> B == other.B && this -> A == other.A;
+// Returns alpha as a 0.0–1.0 fraction (0 = fully transparent, 1 = fully opaque).
+double RGBA::alpha() {
+	return (double)this->A / 0xff;
 }
 
-bool RGBA::operator ==(const RGBA& other) const {
-
-	return this -> R == other.R && this -> G == other.G &&
-		this -> B == other.B && this -> A == other.A;
+void RGBA::to_RGB565(std::span<const RGBA> src, std::span<uint16_t> dst) {
 
+	for ( size_t i = 0; i < src.size() && i < dst.size(); i++ )
+		dst[i] = src[i].RGB565();
 }
 
-bool RGBA::operator !=(const RGBA& other) {
+void RGBA::to_XRGB8888(std::span<const RGBA> src, std::span<uint32_t> dst) {
 
-	return !(*this == other);
+	for ( size_t i = 0; i < src.size() && i < dst.size(); i++ )
+		dst[i] = src[i].XRGB8888();
 }
 
-bool RGBA::operator !=(const RGBA& other) const {
+void RGBA::premultiply(std::span<const RGBA> src, std::span<RGBA> dst) {
 
-	return !(*this == other);
+	for ( size_t i = 0; i < src.size() && i < dst.size(); i++ )
+		dst[i] = src[i].premultiplied();
 }
 
-RGBA& RGBA::operator =(const RGBA& other) {
+void RGBA::mix(std::span<const RGBA> a, std::span<const RGBA> b, std::span<RGBA> dst, unsigned int weight) {
 
-	this -> R = other.R;
-	this -> G = other.G;
-	this -> B = other.B;
-	this -> A = other.A;
-	return *this;
-}
+	size_t n = std::min({ a.size(), b.size(), dst.size() }) * sizeof(RGBA);
+	unsigned int w = weight > 256 ? 256 : weight;
 
-// Returns alpha as a 0.0–1.0 fraction (0 = fully transparent, 1 = fully opaque).
-double RGBA::alpha() {
-	return (double)this->A / 0xff;
+	const unsigned char *pa = reinterpret_cast<const unsigned char*>(a.data());
+	const unsigned char *pb = reinterpret_cast<const unsigned char*>(b.data());
+	unsigned char *pd = reinterpret_cast<unsigned char*>(dst.data());
+
+	for ( size_t i = 0; i < n; i++ )
+		pd[i] = ( pa[i] * ( 256 - w ) + pb[i] * w ) >> 8;
 }
 
-std::vector<unsigned char> RGBA::RGB565() const {
+// Compares 8 pixels (32 bytes) at a time; fixed size memcmp is inlined as a
+// few wide compares.
+size_t RGBA::mismatch(std::span<const RGBA> a, std::span<const RGBA> b) {
+
+	size_t n = a.size() < b.size() ? a.size() : b.size();
+	size_t i = 0;
+
+	for ( ; i + 8 <= n; i += 8 )
+		if ( std::memcmp(a.data() + i, b.data() + i, 8 * sizeof(RGBA)) != 0 )
+			break;
+
+	while ( i < n && a[i] == b[i] )
+		i++;
 
-	return {
-		(unsigned char)(( this -> R & 0xf8 ) | (( this -> G & 0xe0 ) >> 5 )),
-		(unsigned char)((( this -> G & 0x1c ) << 3 ) | (( this -> B & 0xf8 ) >> 3 ))
-		};
+	return i;
 }
 
 // Converts our 0–255 alpha (255 = opaque) to GD's 0–127 alpha (0 = opaque).
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <stdexcept>
 
@@ -9,6 +10,8 @@
 #include "display.hpp"
 #include "timer.hpp"
 #include "layout.hpp"
+#include "trace.hpp"
+#include "tick.hpp"
 #include "scheduler.hpp"
 
 // Data thread update interval: frequent enough for any plugin's own interval check.
@@ -17,11 +20,64 @@ static constexpr auto DATA_INTERVAL   = std::chrono::milliseconds(100);
 // Render thread target frame time (~30 fps).
 static constexpr auto RENDER_INTERVAL = std::chrono::milliseconds(33);
 
+// Time widget updates of the shown page may take in one frame; the rest of
+// the frame is left for layout render and refresh.
+static constexpr auto WIDGET_BUDGET   = std::chrono::milliseconds(20);
+
+// A widget whose drawing updates take longer than WIDGET_OVERRUN this many
+// times in a row is asked to switch to its cheaper drawing mode.
+static constexpr auto WIDGET_OVERRUN  = std::chrono::milliseconds(10);
+static constexpr int OVERRUN_LIMIT    = 5;
+
+// Widgets synced to wall clock that can draw ahead are updated and rendered
+// this long before their boundary, and the frame is shown on it.
+static constexpr auto SYNC_LEAD       = std::chrono::milliseconds(20);
+
+// How long before a page::next() timer fires the next page of the sequence
+// is updated and rendered into its canvas.
+static constexpr auto PRERENDER_LEAD  = std::chrono::milliseconds(500);
+
 // How often the main wait loop polls for the stop flag.
 static constexpr auto MAIN_POLL       = std::chrono::milliseconds(100);
 
+static constexpr const char* STAGE_DURATION  = "lcd2_stage_duration_seconds";
+static constexpr const char* WIDGET_DURATION = "lcd2_widget_update_duration_seconds";
+static constexpr const char* PLUGIN_DURATION = "lcd2_plugin_update_duration_seconds";
+static constexpr const char* LOCK_WAIT       = "lcd2_data_mutex_wait_seconds";
+
 SCHEDULER::SCHEDULER(DISPLAY* display, bool threaded)
-    : _display(display), _is_threaded(threaded) {}
+    : _display(display), _is_threaded(threaded) {
+
+    metrics.describe(STAGE_DURATION,  "Time spent in each pipeline stage; frame is a whole render cycle without sleep");
+    metrics.describe(WIDGET_DURATION, "Time spent in update() of each widget");
+    metrics.describe(PLUGIN_DURATION, "Time spent in update() of each plugin");
+    metrics.describe(LOCK_WAIT,       "Time waited to acquire the data mutex");
+    metrics.describe("lcd2_render_cycles_total",   "Render cycles run");
+    metrics.describe("lcd2_frames_total",          "Render cycles that rendered and refreshed the display");
+    metrics.describe("lcd2_frame_overruns_total",  "Render cycles that took longer than the frame interval");
+    metrics.describe("lcd2_data_cycles_total",     "Plugin and timer update cycles run");
+    metrics.describe("lcd2_widget_deferred_total", "Widget updates left for the next frame when the widget budget ran out");
+    metrics.describe("lcd2_widget_overruns_total", "Widget updates that drew for longer than the widget overrun limit");
+    metrics.describe("lcd2_widget_degraded_total", "Widgets switched to cheaper drawing after repeated overruns");
+
+    _stages = {
+        .plugins     = &metrics.histogram(STAGE_DURATION, "stage", "plugins"),
+        .timers      = &metrics.histogram(STAGE_DURATION, "stage", "timers"),
+        .widgets     = &metrics.histogram(STAGE_DURATION, "stage", "widgets"),
+        .render      = &metrics.histogram(STAGE_DURATION, "stage", "render"),
+        .refresh     = &metrics.histogram(STAGE_DURATION, "stage", "refresh"),
+        .frame       = &metrics.histogram(STAGE_DURATION, "stage", "frame"),
+        .data_wait   = &metrics.histogram(LOCK_WAIT, "thread", "data"),
+        .render_wait = &metrics.histogram(LOCK_WAIT, "thread", "render"),
+        .cycles      = &metrics.counter("lcd2_render_cycles_total"),
+        .frames      = &metrics.counter("lcd2_frames_total"),
+        .overruns    = &metrics.counter("lcd2_frame_overruns_total"),
+        .data_cycles = &metrics.counter("lcd2_data_cycles_total"),
+        .deferred    = &metrics.counter("lcd2_widget_deferred_total"),
+        .widget_overruns = &metrics.counter("lcd2_widget_overruns_total"),
+        .degraded    = &metrics.counter("lcd2_widget_degraded_total"),
+    };
+}
 
 SCHEDULER::~SCHEDULER() {
     _display = nullptr;
@@ -39,84 +95,422 @@ bool SCHEDULER::exit_loop() const {
     return _stop.load(std::memory_order_relaxed);
 }
 
+void SCHEDULER::reload() {
+    _reload.store(true, std::memory_order_relaxed);
+}
+
+// Called with _data_mutex held, between frames of a transition. Timers are
+// not updated while it runs, so a page switching timer of page that is due
+// by now would otherwise fire only after the transition.
+bool SCHEDULER::interrupt(int page) {
+
+    if (_stop.load(std::memory_order_relaxed) || _reload.load(std::memory_order_relaxed))
+        return true;
+
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+
+    for (auto& [key, t] : _display->timers) {
+        if (!t.is_global(_display->layout) && !t.on_page(_display->layout, page))
+            continue;
+        if (t.page_action() == TIMER::NO_PAGE_ACTION || !t.active())
+            continue;
+        if (t.next_update() <= now)
+            return true;
+    }
+
+    return false;
+}
+
+void SCHEDULER::wake() {
+    {
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+        _wake = true;
+    }
+    _wake_cv.notify_all();
+}
+
+// Sleeps until tp, or until wake() is called.
+void SCHEDULER::sleep_until(std::chrono::steady_clock::time_point tp) {
+    std::unique_lock<std::mutex> lock(_wake_mutex);
+    _wake_cv.wait_until(lock, tp, [this]{ return _wake || _stop.load(std::memory_order_relaxed); });
+    _wake = false;
+}
+
 // ── Initialisation (called once in main thread before threads start) ─────────
 
 bool SCHEDULER::run_once() {
 
-    _display->clean_up();
+    _display->prepare();
+    return true;
+}
+
+// Threaded, runs on data thread with _data_mutex held. Current page is rendered and shown right away,
+// widgets that were re-created would otherwise wait for their interval.
+void SCHEDULER::reload_config() {
 
-    if (_display->canvas.empty())
-        _display->init_canvas();
+    TRACE_SPAN("reload");
 
-    _display->clear();
-    return true;
+    // background preload jobs refer to widgets that may get replaced
+    if (_pool != nullptr)
+        _pool->wait();
+
+    try {
+        if (!_display->reload())
+            return;
+
+        _prerendered.store(NO_PAGE, std::memory_order_relaxed);
+        _widget_stats.clear();
+        _plugin_histograms.clear();
+        _current_page.store(_display->page_number(), std::memory_order_relaxed);
+
+        update_widgets(_current_page.load(std::memory_order_relaxed));
+        _display->layout->render();
+        _display->refresh();
+
+    } catch (const std::exception& e) {
+        logger::error["scheduler"] << "configuration reload failed: " << e.what() << std::endl;
+    }
 }
 
 // ── Pipeline helpers ──────────────────────────────────────────────────────────
 
 void SCHEDULER::update_plugins() {
 
+    TRACE_SPAN("plugins");
+    auto t0 = std::chrono::steady_clock::now();
+
     for (auto it = _display->plugins->begin(); it != _display->plugins->end(); ++it) {
         auto tp0 = std::chrono::steady_clock::now();
-        it->second->update();
-        auto tp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::steady_clock::now() - tp0).count();
+        {
+            TRACE_SPAN("plugin", it->first);
+            it->second->update();
+        }
+        auto tp1 = std::chrono::steady_clock::now();
+        HISTOGRAM*& histogram = _plugin_histograms[it->second.get()];
+        if (histogram == nullptr)
+            histogram = &metrics.histogram(PLUGIN_DURATION, "plugin", it->first);
+        histogram->record(tp1 - tp0);
+        auto tp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(tp1 - tp0).count();
         if (tp_ms > 50)
             logger::verbose["scheduler"] << "plugin '" << it->first << "' update took "
                 << tp_ms << "ms" << std::endl;
     }
+
+    _stages.plugins->record(std::chrono::steady_clock::now() - t0);
 }
 
 void SCHEDULER::update_timers() {
 
     int page = _current_page.load(std::memory_order_relaxed);
+    auto t0 = std::chrono::steady_clock::now();
+
+    TRACE_SPAN("timers");
 
     for (auto& [key, _] : _display->timers) {
         TIMER& t = _display->timers[key];
-        if (t.is_global(_display->layout) || t.on_page(_display->layout, page))
+        if (t.is_global(_display->layout) || t.on_page(_display->layout, page)) {
+            TRACE_SPAN("timer", key);
             t.update();
+        }
     }
+
+    _stages.timers->record(std::chrono::steady_clock::now() - t0);
 }
 
+// Updates one widget and keeps its statistics; a widget that keeps drawing
+// for longer than WIDGET_OVERRUN is degraded once.
+bool SCHEDULER::update_widget(const LAYOUT::DRAW& d, WIDGET_STATS& stats) {
+
+    auto tw0 = std::chrono::steady_clock::now();
+    bool updated;
+    {
+        TRACE_SPAN("widget", d.name);
+        updated = d.ptr->update();
+    }
+    auto took = std::chrono::steady_clock::now() - tw0;
+
+    if (stats.histogram == nullptr)
+        stats.histogram = &metrics.histogram(WIDGET_DURATION, "widget", d.name);
+    stats.histogram->record(took);
+
+    auto tw_ms = std::chrono::duration_cast<std::chrono::milliseconds>(took).count();
+    if (tw_ms > 50)
+        logger::verbose["scheduler"] << "widget '" << d.name << "' update took "
+            << tw_ms << "ms" << std::endl;
+
+    // updates that had nothing to draw say nothing about cost of drawing
+    if (!updated)
+        return false;
+
+    if (took <= WIDGET_OVERRUN) {
+        stats.overruns = 0;
+        return true;
+    }
+
+    stats.total_overruns++;
+    _stages.widget_overruns->fetch_add(1, std::memory_order_relaxed);
+
+    if (++stats.overruns < OVERRUN_LIMIT || stats.degraded)
+        return true;
+
+    stats.degraded = true;
+
+    if (d.ptr->degrade()) {
+        _stages.degraded->fetch_add(1, std::memory_order_relaxed);
+        logger::info["scheduler"] << "widget '" << d.name << "' took over " << WIDGET_OVERRUN.count() << "ms to draw "
+            << OVERRUN_LIMIT << " times in a row (" << stats.total_overruns << " in total), switched to cheaper drawing" << std::endl;
+    } else logger::verbose["scheduler"] << "widget '" << d.name << "' keeps taking over " << WIDGET_OVERRUN.count()
+            << "ms to draw and has no cheaper way to draw" << std::endl;
+
+    return true;
+}
+
+// Updates widgets of the shown page within WIDGET_BUDGET. Widgets are visited
+// by priority raised by one for every frame in a row they have been left out,
+// so that a low priority widget cannot be kept waiting for good; once the
+// budget is spent the rest wait for the next frame, so that an expensive
+// widget delays the others by a frame instead of making every frame late.
 bool SCHEDULER::update_widgets() {
 
     int page = _current_page.load(std::memory_order_relaxed);
     bool any_updated = false;
 
-    if (!_display->layout->pages.contains(page))
+    auto draws = _display->layout->compiled.find(page);
+    if (draws == _display->layout->compiled.end())
         return false;
 
-    for (auto& [k, layer] : _display->layout->pages[page].layers) {
+    TRACE_SPAN("widgets");
+    auto t0 = std::chrono::steady_clock::now();
+
+    _order.clear();
+    for (const LAYOUT::DRAW& d : draws->second) {
+        _order.push_back(&d);
+        _widget_stats.try_emplace(d.ptr);
+    }
+
+    std::stable_sort(_order.begin(), _order.end(), [this](const LAYOUT::DRAW* a, const LAYOUT::DRAW* b) {
+        int da = _widget_stats[a->ptr].deferred, db = _widget_stats[b->ptr].deferred;
+        if (int pa = a->ptr->priority() + da, pb = b->ptr->priority() + db; pa != pb)
+            return pa > pb;
+        return da > db;
+    });
+
+    for (const LAYOUT::DRAW* d : _order) {
         if (_stop.load(std::memory_order_relaxed)) break;
-        for (auto& wlink : layer.widgets) {
-            if (_stop.load(std::memory_order_relaxed)) break;
-            auto tw0 = std::chrono::steady_clock::now();
-            bool updated = wlink.update();
-            if (updated) any_updated = true;
-            auto tw_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now() - tw0).count();
-            if (tw_ms > 50)
-                logger::verbose["scheduler"] << "widget '" << wlink.name << "' update took "
-                    << tw_ms << "ms" << std::endl;
+
+        WIDGET_STATS& stats = _widget_stats[d->ptr];
+
+        if (std::chrono::steady_clock::now() - t0 > WIDGET_BUDGET) {
+            stats.deferred++;
+            _stages.deferred->fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        stats.deferred = 0;
+        if (update_widget(*d, stats))
+            any_updated = true;
+    }
+
+    _stages.widgets->record(std::chrono::steady_clock::now() - t0);
+    return any_updated;
+}
+
+// Updates every widget of page, regardless of budget; widgets that have
+// something new to draw are added to updated
+bool SCHEDULER::update_widgets(int page, std::unordered_set<const widget::WIDGET*>* updated) {
+
+    bool any_updated = false;
+
+    auto draws = _display->layout->compiled.find(page);
+    if (draws == _display->layout->compiled.end())
+        return false;
+
+    TRACE_SPAN("widgets");
+    auto t0 = std::chrono::steady_clock::now();
+
+    for (const LAYOUT::DRAW& d : draws->second) {
+        if (_stop.load(std::memory_order_relaxed)) break;
+        if (update_widget(d, _widget_stats[d.ptr])) {
+            any_updated = true;
+            if (updated != nullptr)
+                updated->insert(d.ptr);
         }
     }
 
+    _stages.widgets->record(std::chrono::steady_clock::now() - t0);
     return any_updated;
 }
 
+// Time left until the first page::next() timer running on page is due,
+// or max() when no such timer is active there.
+std::chrono::milliseconds SCHEDULER::until_page_switch(int page) {
+
+    auto now = TICK::millis();
+    auto left = std::chrono::milliseconds::max();
+
+    for (auto& [key, t] : _display->timers) {
+        if (!t.is_global(_display->layout) && !t.on_page(_display->layout, page))
+            continue;
+        if (t.page_action() != TIMER::PAGE_NEXT || !t.active())
+            continue;
+        left = std::min(left, t.last_updated + std::chrono::milliseconds(t.interval()) - now);
+    }
+
+    return left;
+}
+
+// Earliest boundary a synced widget of page is due on, or max() when page has
+// none. ahead tells if every widget due then can be drawn before it.
+std::chrono::milliseconds SCHEDULER::next_sync(int page, bool& ahead) {
+
+    auto next = std::chrono::milliseconds::max();
+    ahead = false;
+
+    auto draws = _display->layout->compiled.find(page);
+    if (draws == _display->layout->compiled.end())
+        return next;
+
+    for (const LAYOUT::DRAW& d : draws->second) {
+        if (d.ptr->sync() == TICK::NONE)
+            continue;
+
+        auto due = d.ptr->next_update();
+        if (due < next) {
+            next = due;
+            ahead = d.ptr->draws_ahead();
+        } else if (due == next)
+            ahead = ahead && d.ptr->draws_ahead();
+    }
+
+    return next;
+}
+
+// Earliest boundary a synced timer running on page is due on, or max()
+std::chrono::milliseconds SCHEDULER::next_timer_sync(int page) {
+
+    auto next = std::chrono::milliseconds::max();
+
+    for (auto& [key, t] : _display->timers) {
+        if (t.sync() == TICK::NONE)
+            continue;
+        if (!t.is_global(_display->layout) && !t.on_page(_display->layout, page))
+            continue;
+        next = std::min(next, t.next_update());
+    }
+
+    return next;
+}
+
+// Updates widgets of the upcoming page of the sequence and renders them into
+// its canvas shortly before the switch, so that setpage() only has to refresh.
+// Runs with _data_mutex held, as it reads timers and draws widgets.
+void SCHEDULER::prerender() {
+
+    const LAYOUT* layout = _display->layout;
+    int page = _current_page.load(std::memory_order_relaxed);
+
+    if (layout->page_sequence.empty())
+        return;
+
+    int index = layout->next_page_index < (int)layout->page_sequence.size() ? layout->next_page_index : 0;
+    int next = layout->page_sequence[index];
+
+    if (next == page || !_display->layout->compiled.contains(next))
+        return;
+
+    // A timer that fired without switching (condition was false) leaves
+    // the warm page behind; render it again before the next attempt.
+    if (until_page_switch(page) > PRERENDER_LEAD) {
+        _prerendered.store(NO_PAGE, std::memory_order_relaxed);
+        return;
+    }
+
+    if (_prerendered.load(std::memory_order_relaxed) == next)
+        return;
+
+    std::string name = LAYOUT::page_name(next);
+    TRACE_SPAN("prerender", name);
+
+    std::unordered_set<const widget::WIDGET*> updated;
+    update_widgets(next, &updated);
+    _display->layout->render(&next);
+    _prerendered.store(next, std::memory_order_relaxed);
+
+    // A widget also placed on the shown page (a shared header clock) has
+    // just used up its update there; show it now instead of at the switch.
+    if (auto draws = _display->layout->compiled.find(page); !updated.empty() && draws != _display->layout->compiled.end()) {
+        for (const LAYOUT::DRAW& d : draws->second) {
+            if (updated.contains(d.ptr)) {
+                _display->layout->render();
+                _display->refresh();
+                break;
+            }
+        }
+    }
+
+    logger::debug["scheduler"] << "prerendered " << name << std::endl;
+}
+
+bool SCHEDULER::claim_prerendered(int page) {
+
+    return _prerendered.exchange(NO_PAGE, std::memory_order_relaxed) == page;
+}
+
+// Queues asset loading of widgets on page that were not yet seen. preload()
+// evaluates widget properties, so this runs before the worker threads start.
+size_t SCHEDULER::preload(int page, std::unordered_set<const widget::WIDGET*>& seen) {
+
+    auto draws = _display->layout->compiled.find(page);
+    size_t count = 0;
+
+    if (draws == _display->layout->compiled.end() || _pool == nullptr)
+        return 0;
+
+    for (const LAYOUT::DRAW& d : draws->second) {
+        if (!seen.insert(d.ptr).second)
+            continue;
+        if (auto job = d.ptr->preload()) {
+            _pool->submit(std::move(job));
+            count++;
+        }
+    }
+
+    return count;
+}
+
 // ── Data thread: plugins + timers ─────────────────────────────────────────────
 
 void SCHEDULER::data_loop(std::stop_token token) {
 
+    TRACE::thread_name("data");
+
     while (!token.stop_requested() && !_stop.load(std::memory_order_relaxed)) {
 
         auto next = std::chrono::steady_clock::now() + DATA_INTERVAL;
 
         {
+            TRACE_SPAN("data_cycle");
             auto t0 = std::chrono::steady_clock::now();
             std::lock_guard<std::mutex> lock(_data_mutex);
+            TICK::capture();
+            _stages.data_wait->record(TICK::steady() - t0);
+            if (_reload.exchange(false, std::memory_order_relaxed))
+                reload_config();
+            // reload that could not restore a layout asks to exit and leaves none
+            if (_stop.load(std::memory_order_relaxed))
+                break;
             update_plugins();
             update_timers();
+            _stages.data_cycles->fetch_add(1, std::memory_order_relaxed);
+
+            // synced timers are run on their boundary, not on next cycle
+            if (auto sync = next_timer_sync(_current_page.load(std::memory_order_relaxed));
+                sync != std::chrono::milliseconds::max()) {
+                auto at = TICK::steady(sync);
+                if (at > std::chrono::steady_clock::now())
+                    next = std::min(next, at);
+            }
             auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::steady_clock::now() - t0).count();
             if (elapsed_ms > 50)
@@ -133,13 +527,30 @@ void SCHEDULER::render_loop(std::stop_token token) {
 
     long _frame = 0;
 
+    // Next boundary of synced widgets on current page
+    auto sync = std::chrono::milliseconds::max();
+    bool ahead = false;
+
+    TRACE::thread_name("render");
+
     while (!token.stop_requested() && !_stop.load(std::memory_order_relaxed)) {
 
-        auto frame_start = std::chrono::steady_clock::now();
+        TRACE::SPAN cycle_span("render_cycle");
+        TICK::capture();
+        auto frame_start = TICK::steady();
+
+        // Frame drawn ahead for a boundary of synced widgets; widgets see the
+        // time of the boundary and the frame is shown on it
+        bool on_tick = ahead && TICK::millis() + SYNC_LEAD >= sync;
+        if (on_tick)
+            TICK::capture(sync);
+        auto waited = std::chrono::steady_clock::duration::zero();
 
         if (++_frame % 300 == 0)
             logger::debug["scheduler"] << "render alive, frame=" << _frame << std::endl;
 
+        _stages.cycles->fetch_add(1, std::memory_order_relaxed);
+
         // Snapshot current page; exceptions mean display is shutting down
         try {
             _current_page.store(_display->page_number(), std::memory_order_relaxed);
@@ -153,8 +564,12 @@ void SCHEDULER::render_loop(std::stop_token token) {
         {
             auto t0 = std::chrono::steady_clock::now();
             std::lock_guard<std::mutex> lock(_data_mutex);
+            if (_stop.load(std::memory_order_relaxed))
+                break;
             auto t1 = std::chrono::steady_clock::now();
+            _stages.render_wait->record(t1 - t0);
             any_updated = update_widgets();
+            sync = next_sync(_current_page.load(std::memory_order_relaxed), ahead);
             auto t2 = std::chrono::steady_clock::now();
             auto lock_wait = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
             auto widget_ms = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
@@ -170,23 +585,61 @@ void SCHEDULER::render_loop(std::stop_token token) {
         // and widget bitmaps -> iterator invalidation / use-after-free. Share
         // _data_mutex (setpage runs under it on the data thread, so they exclude).
         if (any_updated && !_stop.load(std::memory_order_relaxed)) {
-            std::lock_guard<std::mutex> lock(_data_mutex);
+            auto tl = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lock(_data_mutex);
+            if (_stop.load(std::memory_order_relaxed))
+                break;
             auto t3 = std::chrono::steady_clock::now();
+            _stages.render_wait->record(t3 - tl);
             _display->layout->render();
             auto t4 = std::chrono::steady_clock::now();
-            _display->refresh();
+            auto tr = t4;
+            // hold frame drawn ahead until its tick, without blocking data thread
+            if (on_tick && t4 < TICK::steady()) {
+                lock.unlock();
+                std::this_thread::sleep_until(TICK::steady());
+                lock.lock();
+                tr = std::chrono::steady_clock::now();
+                waited = tr - t4;
+            }
+            {
+                TRACE_SPAN("refresh");
+                _display->refresh();
+            }
             auto t5 = std::chrono::steady_clock::now();
+            _stages.render->record(t4 - t3);
+            _stages.refresh->record(t5 - tr);
+            _stages.frames->fetch_add(1, std::memory_order_relaxed);
             auto render_ms  = std::chrono::duration_cast<std::chrono::milliseconds>(t4 - t3).count();
-            auto refresh_ms = std::chrono::duration_cast<std::chrono::milliseconds>(t5 - t4).count();
+            auto refresh_ms = std::chrono::duration_cast<std::chrono::milliseconds>(t5 - tr).count();
             if (render_ms > 50 || refresh_ms > 50)
                 logger::verbose["scheduler"] << "render: layout=" << render_ms
                     << "ms refresh=" << refresh_ms << "ms" << std::endl;
         }
 
-        auto elapsed  = std::chrono::steady_clock::now() - frame_start;
-        auto leftover = RENDER_INTERVAL - elapsed;
-        if (leftover > std::chrono::milliseconds(0))
-            std::this_thread::sleep_for(leftover);
+        auto frame_time = std::chrono::steady_clock::now() - frame_start - waited;
+        _stages.frame->record(frame_time);
+        if (frame_time > RENDER_INTERVAL)
+            _stages.overruns->fetch_add(1, std::memory_order_relaxed);
+
+        // Warm the next page with what is left of the frame
+        if (frame_time < RENDER_INTERVAL && !_stop.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(_data_mutex);
+            if (!_stop.load(std::memory_order_relaxed))
+                prerender();
+        }
+
+        cycle_span.end();
+
+        // wake up for the next boundary; one that has passed already is
+        // left for the next frame, a deferred widget would spin otherwise
+        auto wake = frame_start + RENDER_INTERVAL;
+        if (sync != std::chrono::milliseconds::max()) {
+            auto at = TICK::steady(ahead ? sync - SYNC_LEAD : sync);
+            if (at > std::chrono::steady_clock::now())
+                wake = std::min(wake, at);
+        }
+        sleep_until(wake);
     }
 }
 
@@ -214,9 +667,19 @@ void SCHEDULER::run_unthreaded() {
 
     int cycle = 0;
 
+    TRACE::thread_name("main");
+
     while (!_stop.load(std::memory_order_relaxed)) {
 
-        auto start = std::chrono::steady_clock::now();
+        TRACE::SPAN cycle_span("cycle");
+        TICK::capture();
+        auto start = TICK::steady();
+
+        if (_reload.exchange(false, std::memory_order_relaxed))
+            reload_config();
+
+        if (_stop.load(std::memory_order_relaxed))
+            break;
 
         try {
             _current_page.store(_display->page_number(), std::memory_order_relaxed);
@@ -225,6 +688,9 @@ void SCHEDULER::run_unthreaded() {
             continue;
         }
 
+        _stages.cycles->fetch_add(1, std::memory_order_relaxed);
+        _stages.data_cycles->fetch_add(1, std::memory_order_relaxed);
+
         update_plugins();
         update_timers();
 
@@ -234,8 +700,14 @@ void SCHEDULER::run_unthreaded() {
             auto tr0 = std::chrono::steady_clock::now();
             _display->layout->render();
             auto tr1 = std::chrono::steady_clock::now();
-            _display->refresh();
+            {
+                TRACE_SPAN("refresh");
+                _display->refresh();
+            }
             auto tr2 = std::chrono::steady_clock::now();
+            _stages.render->record(tr1 - tr0);
+            _stages.refresh->record(tr2 - tr1);
+            _stages.frames->fetch_add(1, std::memory_order_relaxed);
             auto layout_ms  = std::chrono::duration_cast<std::chrono::milliseconds>(tr1 - tr0).count();
             auto refresh_ms = std::chrono::duration_cast<std::chrono::milliseconds>(tr2 - tr1).count();
             if (layout_ms > 50 || refresh_ms > 50)
@@ -244,17 +716,33 @@ void SCHEDULER::run_unthreaded() {
         }
 
         auto elapsed = std::chrono::steady_clock::now() - start;
+        _stages.frame->record(elapsed);
+
+        if (!_stop.load(std::memory_order_relaxed))
+            prerender();
+
+        cycle_span.end();
 
         logger::verbose["scheduler"] << "cycle #" << cycle++
             << " " << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
             << "ms (updated=" << any_updated << ")" << std::endl;
 
-        // Target ~600 ms cycle; sleep the remainder (minimum 50 ms)
+        // Target ~600 ms cycle; sleep the remainder (minimum 50 ms) unless woken
+        // or a synced widget or timer is due before that
         auto leftover = std::chrono::milliseconds(600) - elapsed;
-        if (leftover > std::chrono::milliseconds(50))
-            std::this_thread::sleep_for(leftover);
-        else
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        auto wake = leftover > std::chrono::milliseconds(50) ? start + std::chrono::milliseconds(600) :
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+
+        int page = _current_page.load(std::memory_order_relaxed);
+        bool ahead;
+        if (auto sync = std::min(next_sync(page, ahead), next_timer_sync(page));
+            sync != std::chrono::milliseconds::max()) {
+            auto at = TICK::steady(sync);
+            if (at > std::chrono::steady_clock::now())
+                wake = std::min(wake, at);
+        }
+
+        sleep_until(wake);
     }
 }
 
@@ -280,6 +768,9 @@ void SCHEDULER::run() {
 
     if (_stop.load(std::memory_order_relaxed)) return;
 
+    if (_display->watcher != nullptr)
+        _display->watcher->on_change([this]() { wake(); });
+
     logger::verbose["scheduler"] << "starting ("
         << (_is_threaded ? "threaded" : "unthreaded") << ")" << std::endl;
 
@@ -288,15 +779,40 @@ void SCHEDULER::run() {
     // whose layers reference only missing widgets); guard it so the exception
     // cannot escape run() and terminate the process. The main loops below have
     // their own guards around page_number() for the same reason.
+    //
+    // Fonts and images of the first page are loaded in parallel before it is
+    // rendered; the rest of the pages are warmed in background afterwards,
+    // so the panel is not left blank while assets of unseen pages load.
     try {
-        _current_page.store(_display->page_number(), std::memory_order_relaxed);
+        TICK::SCOPE tick;
+        auto t0 = TICK::steady();
+        int page = _display->page_number();
+        std::unordered_set<const widget::WIDGET*> seen;
+
+        _current_page.store(page, std::memory_order_relaxed);
+        _pool = std::make_unique<THREAD_POOL>();
+
+        if (preload(page, seen) > 0)
+            _pool->wait();
 
         // Single initial render so the display shows something immediately
         update_plugins();
         update_timers();
-        update_widgets();
+        update_widgets(page);
         _display->layout->render();
         _display->refresh();
+
+        logger::verbose["scheduler"] << "first page shown in " << std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - t0).count() << "ms" << std::endl;
+
+        size_t queued = 0;
+        for (const auto& [p, _] : _display->layout->compiled)
+            if (p != page)
+                queued += preload(p, seen);
+
+        if (queued > 0)
+            logger::verbose["scheduler"] << "preloading " << queued << " widgets of other pages" << std::endl;
+
     } catch (const std::exception& e) {
         logger::warning["scheduler"] << "initial render skipped: " << e.what() << std::endl;
     }
@@ -312,5 +828,10 @@ void SCHEDULER::run() {
         logger::error["scheduler"] << "loop exited abnormally: " << e.what() << std::endl;
     }
 
+    if (_display != nullptr && _display->watcher != nullptr)
+        _display->watcher->on_change(nullptr);
+
+    _pool.reset();
+
     logger::verbose["scheduler"] << "stopped" << std::endl;
 }
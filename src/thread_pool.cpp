@@ -0,0 +1,79 @@
+#include <exception>
+
+#include "logger.hpp"
+#include "thread_pool.hpp"
+
+THREAD_POOL::THREAD_POOL(size_t threads) {
+
+	if ( threads == 0 )
+		threads = std::thread::hardware_concurrency();
+
+	if ( threads == 0 )
+		threads = 1;
+
+	for ( size_t i = 0; i < threads; i++ )
+		this -> _threads.emplace_back([this](std::stop_token t) { this -> worker(t); });
+}
+
+THREAD_POOL::~THREAD_POOL() {
+
+	for ( auto& t : this -> _threads )
+		t.request_stop();
+
+	this -> _threads.clear();
+}
+
+size_t THREAD_POOL::size() const {
+	return this -> _threads.size();
+}
+
+void THREAD_POOL::submit(std::function<void()> job) {
+
+	if ( !job )
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(this -> _m);
+		this -> _jobs.push_back(std::move(job));
+	}
+
+	this -> _cv.notify_one();
+}
+
+void THREAD_POOL::wait() {
+
+	std::unique_lock<std::mutex> lock(this -> _m);
+	this -> _idle.wait(lock, [this]{ return this -> _jobs.empty() && this -> _running == 0; });
+}
+
+void THREAD_POOL::worker(std::stop_token token) {
+
+	std::unique_lock<std::mutex> lock(this -> _m);
+
+	while ( true ) {
+
+		if ( !this -> _cv.wait(lock, token, [this]{ return !this -> _jobs.empty(); }))
+			break;
+
+		std::function<void()> job = std::move(this -> _jobs.front());
+		this -> _jobs.pop_front();
+		this -> _running++;
+		lock.unlock();
+
+		try {
+			job();
+		} catch ( const std::exception& e ) {
+			logger::error["pool"] << "job failed: " << e.what() << std::endl;
+		}
+
+		lock.lock();
+		this -> _running--;
+
+		if ( this -> _jobs.empty() && this -> _running == 0 )
+			this -> _idle.notify_all();
+	}
+
+	// jobs left behind are dropped, let waiters go
+	this -> _jobs.clear();
+	this -> _idle.notify_all();
+}
@@ -0,0 +1,120 @@
+#include <time.h>
+#include <algorithm>
+#include <vector>
+#include <utility>
+
+#include "tick.hpp"
+
+// How often time zone is re-read for local time.
+static constexpr auto ZONE_INTERVAL = std::chrono::seconds(60);
+
+thread_local TICK::STATE TICK::_state;
+thread_local TICK::LOCAL TICK::_local;
+
+static const std::vector<std::pair<TICK::ALIGN, std::string>> names = {
+	{ TICK::NONE, "none" },
+	{ TICK::SECOND, "second" },
+	{ TICK::MINUTE, "minute" },
+	{ TICK::INTERVAL, "interval" },
+};
+
+void TICK::capture() {
+
+	TICK::_state.steady = std::chrono::steady_clock::now();
+	TICK::_state.wall = std::chrono::system_clock::now();
+	TICK::_state.captured = true;
+}
+
+void TICK::capture(std::chrono::milliseconds wall) {
+
+	TICK::_state.wall = std::chrono::system_clock::time_point(wall);
+	TICK::_state.steady = TICK::steady(wall);
+	TICK::_state.captured = true;
+}
+
+void TICK::release() {
+
+	TICK::_state.captured = false;
+}
+
+std::chrono::steady_clock::time_point TICK::steady() {
+
+	return TICK::_state.captured ? TICK::_state.steady : std::chrono::steady_clock::now();
+}
+
+std::chrono::system_clock::time_point TICK::wall() {
+
+	return TICK::_state.captured ? TICK::_state.wall : std::chrono::system_clock::now();
+}
+
+std::chrono::steady_clock::time_point TICK::steady(std::chrono::milliseconds wall) {
+
+	auto steady = std::chrono::steady_clock::now();
+	auto now = std::chrono::system_clock::now();
+
+	return steady + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::system_clock::time_point(wall) - now);
+}
+
+std::chrono::milliseconds TICK::millis() {
+
+	return std::chrono::duration_cast<std::chrono::milliseconds>(TICK::wall().time_since_epoch());
+}
+
+// localtime_r() does not notice a changed time zone by itself, tzset() makes
+// it read TZ and /etc/localtime again.
+const std::tm& TICK::local() {
+
+	std::time_t t = std::chrono::system_clock::to_time_t(TICK::wall());
+	auto now = TICK::steady();
+
+	if ( TICK::_local.second == -1 || now - TICK::_local.zone_read >= ZONE_INTERVAL ) {
+
+		tzset();
+		TICK::_local.zone_read = now;
+		TICK::_local.second = -1;
+	}
+
+	if ( t != TICK::_local.second ) {
+
+		localtime_r(&t, &TICK::_local.tm);
+		TICK::_local.second = t;
+	}
+
+	return TICK::_local.tm;
+}
+
+std::chrono::milliseconds TICK::next(std::chrono::milliseconds last, int interval, ALIGN align) {
+
+	long long unit = align == TICK::SECOND ? 1000 : ( align == TICK::MINUTE ? 60000 : interval );
+
+	if ( align == TICK::NONE || unit <= 0 )
+		return last + std::chrono::milliseconds(interval);
+
+	long long step = std::max(1LL, ( interval + unit - 1 ) / unit ) * unit;
+	long long slot = last.count() - last.count() % unit;
+
+	return std::chrono::milliseconds(slot + step);
+}
+
+bool TICK::parse(const std::string& name, ALIGN& align) {
+
+	for ( const auto& [a, n] : names ) {
+
+		if ( n == name ) {
+			align = a;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+std::string TICK::name(ALIGN align) {
+
+	for ( const auto& [a, n] : names )
+		if ( a == align )
+			return n;
+
+	return "none";
+}
@@ -11,6 +11,10 @@
 #include "display.hpp"
 #include "layout.hpp"
 #include "action.hpp"
+#include "actions/setpage.hpp"
+#include "actions/prevpage.hpp"
+#include "actions/nextpage.hpp"
+#include "tick.hpp"
 #include "timer.hpp"
 
 TIMER::TIMER() {
@@ -37,7 +41,7 @@ TIMER::TIMER(const std::string& name, CONFIG::MAP *cfg) {
 		throws << "failed to create timer '" << name << "', configuration is missing" << std::endl;
 
 	std::vector<std::string> allowed_keys = {
-		"active", "condition", "action", "interval"
+		"active", "condition", "action", "interval", "sync"
 	};
 
 	for ( auto& [k, v] : *cfg ) {
@@ -112,6 +116,14 @@ TIMER::TIMER(const std::string& name, CONFIG::MAP *cfg) {
 		if ( !CONFIG::parse_option("timer", key, value, &allowed_keys))
 			continue;
 
+		if ( key == "sync" ) {
+
+			std::string s = common::unquoted(common::to_lower(common::trim_ws(std::as_const(value))));
+
+			if ( !TICK::parse(s, this -> _sync))
+				logger::warning["config"] << "timer " << name << " has unknown sync '" << s << "', updates are not aligned" << std::endl;
+		}
+
 		if ( key == "expression" ) {
 
 			std::string expr_name = this -> new_expression_name();
@@ -126,6 +138,20 @@ TIMER::TIMER(const std::string& name, CONFIG::MAP *cfg) {
 		throws << "timer '" << name << "' failed to initialize, either expressions array or action is required" << std::endl;
 
 	this -> _properties["interval"] = std::to_string(this -> interval());
+
+	// command of action, as action::execute() finds it
+	if ( std::string cmd = this -> get_action(); cmd.find_first_of('(') != std::string::npos ) {
+
+		cmd = cmd.substr(0, cmd.find_first_of('('));
+		cmd = common::trim_ws(cmd);
+
+		if ( cmd == action::NEXTPAGE().cmd())
+			this -> _page_action = TIMER::PAGE_NEXT;
+		else if ( cmd == action::PREVPAGE().cmd())
+			this -> _page_action = TIMER::PAGE_PREV;
+		else if ( cmd == action::SETPAGE().cmd())
+			this -> _page_action = TIMER::PAGE_SET;
+	}
 }
 
 const std::string TIMER::new_expression_name() const {
@@ -182,6 +208,8 @@ TIMER& TIMER::operator =(const TIMER& other) {
 
 	this -> _name = other._name;
 	this -> last_updated = other.last_updated;
+	this -> _sync = other._sync;
+	this -> _page_action = other._page_action;
 
 	for ( auto& [k, v] : other._properties )
 		this -> _properties[k] = v;
@@ -203,6 +231,16 @@ int TIMER::interval() {
 	} else return 1500;
 }
 
+TICK::ALIGN TIMER::sync() const {
+
+	return this -> _sync;
+}
+
+std::chrono::milliseconds TIMER::next_update() {
+
+	return TICK::next(this -> last_updated, this -> interval(), this -> _sync);
+}
+
 bool TIMER::active() {
 
 	if ( auto _p = this -> property["active"]; _p.is_number())
@@ -210,6 +248,11 @@ bool TIMER::active() {
 	else return true;
 }
 
+TIMER::PAGE_ACTION TIMER::page_action() const {
+
+	return this -> _page_action;
+}
+
 const std::string TIMER::get_action() const {
 
 	for ( const auto& [k, v] : this -> _properties )
@@ -258,8 +301,8 @@ void TIMER::evaluate(const std::string& expr) {
 
 bool TIMER::update() {
 
-	std::chrono::milliseconds next = this -> last_updated + std::chrono::milliseconds(this -> interval());
-	std::chrono::milliseconds now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+	std::chrono::milliseconds next = this -> next_update();
+	std::chrono::milliseconds now = TICK::millis();
 
 	if ( now < next )
 		return false;
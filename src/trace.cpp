@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <sstream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <csignal>
+#include <condition_variable>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "logger.hpp"
+#include "trace.hpp"
+
+// How often pending SIGUSR1 dump requests are checked.
+static constexpr auto DUMP_POLL = std::chrono::milliseconds(100);
+
+struct TRACE_EVENT {
+	const char *name;
+	char arg[32];
+	uint64_t start;
+	uint64_t end;
+};
+
+// Written only by its own thread; head is published with release order after
+// the slot is filled, so a reader that copies slots below head and re-checks
+// head afterwards can discard anything overwritten while it was copying.
+struct TRACE_RING {
+	uint64_t epoch;
+	long tid;
+	std::string name;
+	std::vector<TRACE_EVENT> events;
+	std::atomic<uint64_t> head{0};
+};
+
+std::atomic<bool> TRACE::_enabled{false};
+
+static std::mutex _m;
+static std::vector<std::shared_ptr<TRACE_RING>> _rings;
+static std::string _filename;
+static size_t _capacity = 16384;
+static std::atomic<uint64_t> _epoch{0};
+static std::atomic<bool> _dump_requested{false};
+static std::jthread _thread;
+static void (*_previous_handler)(int) = SIG_DFL;
+
+static thread_local std::shared_ptr<TRACE_RING> _ring;
+static thread_local std::string _thread_name;
+
+static void on_sigusr1(int) {
+	_dump_requested.store(true, std::memory_order_relaxed);
+}
+
+static TRACE_RING* thread_ring() {
+
+	std::lock_guard<std::mutex> lock(_m);
+
+	if ( _ring == nullptr || _ring -> epoch != _epoch ) {
+
+		_ring = std::make_shared<TRACE_RING>();
+		_ring -> epoch = _epoch;
+		_ring -> tid = ::syscall(SYS_gettid);
+		_ring -> name = _thread_name;
+		_ring -> events.resize(_capacity);
+		_rings.push_back(_ring);
+	}
+
+	return _ring.get();
+}
+
+bool TRACE::enabled() {
+	return TRACE::_enabled.load(std::memory_order_relaxed);
+}
+
+void TRACE::enable(const std::string& filename, size_t events_per_thread) {
+
+	TRACE::disable();
+
+	{
+		std::lock_guard<std::mutex> lock(_m);
+		_filename = filename;
+		_capacity = events_per_thread < 64 ? 64 : events_per_thread;
+		_rings.clear();
+		_epoch++;
+	}
+
+	_dump_requested.store(false);
+	_previous_handler = std::signal(SIGUSR1, on_sigusr1);
+
+	_thread = std::jthread([](std::stop_token token) {
+
+		std::mutex m;
+		std::condition_variable_any cv;
+		std::unique_lock<std::mutex> lock(m);
+
+		while ( !token.stop_requested()) {
+
+			cv.wait_for(lock, token, DUMP_POLL, []{ return false; });
+
+			if ( _dump_requested.exchange(false))
+				TRACE::dump();
+		}
+	});
+
+	TRACE::_enabled.store(true);
+	logger::info["trace"] << "recording trace to " << filename << ", send SIGUSR1 to write it out" << std::endl;
+}
+
+void TRACE::disable() {
+
+	if ( !TRACE::_enabled.exchange(false))
+		return;
+
+	if ( _thread.joinable()) {
+		_thread.request_stop();
+		_thread.join();
+	}
+
+	std::signal(SIGUSR1, _previous_handler == SIG_ERR ? SIG_DFL : _previous_handler);
+	TRACE::dump();
+}
+
+void TRACE::thread_name(const std::string& name) {
+
+	_thread_name = name;
+
+	if ( TRACE::enabled())
+		thread_ring() -> name = name;
+}
+
+void TRACE::record(const char *name, const char *arg, uint64_t start, uint64_t end) {
+
+	TRACE_RING *ring = _ring != nullptr && _ring -> epoch == _epoch.load(std::memory_order_relaxed) ? _ring.get() : thread_ring();
+	uint64_t h = ring -> head.load(std::memory_order_relaxed);
+	TRACE_EVENT& ev = ring -> events[h % ring -> events.size()];
+
+	ev.name = name;
+	ev.start = start;
+	ev.end = end;
+
+	if ( arg != nullptr ) {
+		std::strncpy(ev.arg, arg, sizeof(ev.arg) - 1);
+		ev.arg[sizeof(ev.arg) - 1] = 0;
+	} else ev.arg[0] = 0;
+
+	ring -> head.store(h + 1, std::memory_order_release);
+}
+
+static std::string escape(const char *s) {
+
+	std::string ret;
+
+	for ( ; s != nullptr && *s != 0; s++ ) {
+
+		if ( *s == '"' || *s == '\\' ) {
+			ret += '\\';
+			ret += *s;
+		} else if ((unsigned char)*s < 0x20 ) {
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)*s);
+			ret += buf;
+		} else ret += *s;
+	}
+
+	return ret;
+}
+
+bool TRACE::dump() {
+
+	std::stringstream os;
+	std::string filename;
+	long pid = ::getpid();
+	size_t count = 0;
+	bool first = true;
+
+	os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	{
+		std::lock_guard<std::mutex> lock(_m);
+		filename = _filename;
+
+		for ( const auto& ring : _rings ) {
+
+			uint64_t head = ring -> head.load(std::memory_order_acquire);
+			uint64_t size = ring -> events.size();
+			uint64_t from = head > size ? head - size : 0;
+			std::vector<TRACE_EVENT> events;
+
+			for ( uint64_t i = from; i < head; i++ )
+				events.push_back(ring -> events[i % size]);
+
+			// anything the writer wrapped over while copying is not reliable, nor
+			// slot of event after, which may be half written
+			uint64_t after = ring -> head.load(std::memory_order_acquire);
+			uint64_t valid = after + 1 > size ? after + 1 - size : 0;
+			size_t skip = std::min<uint64_t>(valid > from ? valid - from : 0, events.size());
+
+			os << ( first ? "" : "," ) << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid <<
+				",\"tid\":" << ring -> tid << ",\"args\":{\"name\":\"" <<
+				escape(ring -> name.empty() ? ( "thread " + std::to_string(ring -> tid)).c_str() : ring -> name.c_str()) << "\"}}";
+			first = false;
+
+			for ( size_t i = skip; i < events.size(); i++ ) {
+
+				const TRACE_EVENT& ev = events[i];
+
+				os << ",\n{\"name\":\"" << escape(ev.name) << "\",\"cat\":\"lcd2\",\"ph\":\"X\",\"pid\":" << pid <<
+					",\"tid\":" << ring -> tid << ",\"ts\":" << ev.start / 1000 << "." << ( ev.start % 1000 ) / 100 <<
+					",\"dur\":" << ( ev.end - ev.start ) / 1000 << "." << (( ev.end - ev.start ) % 1000 ) / 100;
+
+				if ( ev.arg[0] != 0 )
+					os << ",\"args\":{\"name\":\"" << escape(ev.arg) << "\"}";
+
+				os << "}";
+				count++;
+			}
+		}
+	}
+
+	os << "\n]}\n";
+
+	if ( filename.empty())
+		return false;
+
+	std::string tmpname = filename + ".tmp";
+	std::ofstream f(tmpname, std::ios::trunc);
+
+	if ( !( f << os.str()) || ( f.close(), !f ) || std::rename(tmpname.c_str(), filename.c_str()) != 0 ) {
+
+		logger::error["trace"] << "failed to write trace to " << filename << std::endl;
+		std::remove(tmpname.c_str());
+		return false;
+	}
+
+	logger::info["trace"] << "wrote " << count << " trace events to " << filename << std::endl;
+	return true;
+}
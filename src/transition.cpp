@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstring>
+
+#include "logger.hpp"
+#include "display.hpp"
+#include "driver.hpp"
+#include "trace.hpp"
+#include "transition.hpp"
+
+// Frame interval of transition, same as render thread's.
+static constexpr auto FRAME_INTERVAL = std::chrono::milliseconds(33);
+
+// Transition is abandoned for good if a single frame takes longer than this
+// part of its duration; display is too slow to animate and it would only
+// delay the switch.
+static constexpr int SLOW_FRACTION = 4;
+
+static const std::vector<std::pair<TRANSITION::TYPE, std::string>> names = {
+	{ TRANSITION::NONE, "none" },
+	{ TRANSITION::FADE, "fade" },
+	{ TRANSITION::SLIDE_LEFT, "slide_left" },
+	{ TRANSITION::SLIDE_RIGHT, "slide_right" },
+	{ TRANSITION::WIPE_LEFT, "wipe_left" },
+	{ TRANSITION::WIPE_RIGHT, "wipe_right" },
+};
+
+bool TRANSITION::parse(const std::string& name, TYPE& type) {
+
+	std::string s = name;
+	std::replace(s.begin(), s.end(), '-', '_');
+
+	for ( const auto& [t, n] : names ) {
+
+		if ( n == s ) {
+			type = t;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+std::string TRANSITION::name(TYPE type) {
+
+	for ( const auto& [t, n] : names )
+		if ( t == type )
+			return n;
+
+	return "inherit";
+}
+
+bool TRANSITION::flatten(int page_no, std::vector<RGBA>& out) {
+
+	int w = display -> _width;
+
+	out.resize(w * display -> _height);
+
+	for ( int y = 0; y < display -> _height; y++ )
+		if ( !display -> canvas.compose(page_no, y, 0, w, out.data() + y * w))
+			return false;
+
+	// uncovered pixels show background colour as it is; make frame opaque
+	// so that drivers blending it do not mix background in twice
+	for ( RGBA& p : out )
+		p.A = 0xff;
+
+	return true;
+}
+
+// Builds frame at t (0..1) of transition. Slides and wipes move along x axis
+// of display orientation; on canvas that is either panel's rows or columns,
+// so the frame is put together from contiguous runs of the two pages.
+void TRANSITION::compose(TYPE type, double t) {
+
+	if ( type == TRANSITION::FADE ) {
+		RGBA::mix(this -> _from, this -> _to, this -> _frame, (unsigned int)( t * 256 ));
+		return;
+	}
+
+	int w = display -> _width;
+	int h = display -> _height;
+	bool columns = display -> _orientation.isRotated90() || display -> _orientation.isRotated270();
+	bool reversed = display -> _orientation.isRotated90() || display -> _orientation.isRotated180();
+	bool slide = type == TRANSITION::SLIDE_LEFT || type == TRANSITION::SLIDE_RIGHT;
+	int len = columns ? h : w;
+
+	// positions p.. of frame show positions q.. of src
+	auto put = [&](const std::vector<RGBA>& src, int p, int q, int n) {
+
+		if ( n <= 0 )
+			return;
+
+		if ( columns ) {
+			std::memcpy(this -> _frame.data() + p * w, src.data() + q * w, n * w * sizeof(RGBA));
+			return;
+		}
+
+		for ( int y = 0; y < h; y++ )
+			std::memcpy(this -> _frame.data() + y * w + p, src.data() + y * w + q, n * sizeof(RGBA));
+	};
+
+	// pages move towards left by s; on canvas axis may run backwards
+	int s = (int)( t * len ) * ( type == TRANSITION::SLIDE_LEFT || type == TRANSITION::WIPE_LEFT ? 1 : -1 );
+
+	if ( reversed )
+		s = -s;
+
+	int lo = std::max(0, -s);
+	int hi = std::min(len, len - s);
+
+	put(this -> _from, lo, slide ? lo + s : lo, hi - lo);
+
+	if ( s > 0 )
+		put(this -> _to, hi, slide ? 0 : hi, len - hi);
+	else if ( s < 0 )
+		put(this -> _to, 0, slide ? len + s : 0, lo);
+}
+
+bool TRANSITION::run(int from, int to, const STYLE& style) {
+
+	if ( style.type == TRANSITION::NONE || style.type == TRANSITION::INHERIT || style.duration <= 0 ||
+		this -> _slow || display -> driver == nullptr || from == to )
+		return false;
+
+	if ( !this -> flatten(from, this -> _from) || !this -> flatten(to, this -> _to))
+		return false;
+
+	this -> _frame.resize(this -> _to.size());
+
+	std::string type_name = TRANSITION::name(style.type);
+	TRACE_SPAN("transition", type_name);
+
+	auto duration = std::chrono::milliseconds(style.duration);
+	auto start = std::chrono::steady_clock::now();
+	bool finished = true;
+
+	display -> _frame = &this -> _frame;
+
+	while ( true ) {
+
+		auto frame_start = std::chrono::steady_clock::now();
+		double t = std::chrono::duration<double>(frame_start - start) / duration;
+
+		if ( t >= 1.0 )
+			break;
+
+		// cut to page, data thread is needed for what is waiting
+		if ( display -> scheduler != nullptr && display -> scheduler -> interrupt(to)) {
+			finished = false;
+			break;
+		}
+
+		this -> compose(style.type, t);
+		display -> driver -> refresh();
+
+		auto took = std::chrono::steady_clock::now() - frame_start;
+
+		if ( took * SLOW_FRACTION > duration ) {
+
+			logger::info["display"] << "page transitions disabled, display took " <<
+				std::chrono::duration_cast<std::chrono::milliseconds>(took).count() << "ms to show a frame" << std::endl;
+			this -> _slow = true;
+			finished = false;
+			break;
+		}
+
+		std::this_thread::sleep_until(frame_start + FRAME_INTERVAL);
+	}
+
+	display -> _frame = nullptr;
+	return finished;
+}
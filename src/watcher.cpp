@@ -0,0 +1,224 @@
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+
+#include "logger.hpp"
+#include "fs_funcs.hpp"
+#include "watcher.hpp"
+
+static constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF;
+
+// How often the watch thread checks for a stop request while idle.
+static constexpr int WATCH_POLL_MS = 250;
+
+// Network and fuse filesystems; remote writes to these generate no events.
+// Pseudo filesystems such as proc and sysfs are rejected by fs::is_pseudo.
+static const std::vector<unsigned long> REMOTE_FS = {
+	0x6969,		// nfs
+	0xff534d42,	// cifs
+	0xfe534d42,	// smb2
+	0x65735546,	// fuse
+	0x01021997,	// 9p
+};
+
+static bool is_watchable(const std::string& dir) {
+
+	struct statfs sfs;
+
+	if ( statfs(dir.c_str(), &sfs) != 0 || fs::is_pseudo(dir))
+		return false;
+
+	return std::find(REMOTE_FS.begin(), REMOTE_FS.end(), (unsigned long)sfs.f_type) == REMOTE_FS.end();
+}
+
+static void split_path(const std::string& path, std::string& dir, std::string& name) {
+
+	if ( auto pos = path.find_last_of('/'); pos == std::string::npos ) {
+		dir = ".";
+		name = path;
+	} else {
+		dir = pos == 0 ? "/" : path.substr(0, pos);
+		name = path.substr(pos + 1);
+	}
+}
+
+WATCHER::WATCHER() {
+
+	if ( this -> _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC); this -> _fd < 0 ) {
+
+		logger::warning["watcher"] << "inotify is not available, file changes are polled: " << std::strerror(errno) << std::endl;
+		return;
+	}
+
+	this -> _thread = std::jthread([this](std::stop_token t){ this -> watch_loop(t); });
+}
+
+WATCHER::~WATCHER() {
+
+	if ( this -> _thread.joinable()) {
+		this -> _thread.request_stop();
+		this -> _thread.join();
+	}
+
+	if ( this -> _fd >= 0 )
+		::close(this -> _fd);
+
+	this -> _fd = -1;
+}
+
+bool WATCHER::available() const {
+	return this -> _fd >= 0;
+}
+
+void WATCHER::on_change(const std::function<void()>& fn) {
+
+	std::lock_guard<std::mutex> lock(this -> _m);
+	this -> _notify = fn;
+}
+
+// Registers path, if not already watched, and returns its current generation.
+uint64_t WATCHER::subscribe(const std::string& path) {
+
+	if ( this -> _fd < 0 || path.empty())
+		return 0;
+
+	std::string dir, name;
+	split_path(path, dir, name);
+
+	if ( name.empty())
+		return 0;
+
+	std::lock_guard<std::mutex> lock(this -> _m);
+
+	if ( !this -> _dirs.contains(dir)) {
+
+		if ( this -> _unwatchable.contains(dir))
+			return 0;
+		else if ( !is_watchable(dir)) {
+			this -> _unwatchable.insert(dir);
+			return 0;
+		}
+
+		int wd = inotify_add_watch(this -> _fd, dir.c_str(), WATCH_MASK | IN_ONLYDIR);
+
+		if ( wd < 0 ) {
+
+			logger::verbose["watcher"] << "cannot watch " << dir << ": " << std::strerror(errno) << std::endl;
+			return 0;
+		}
+
+		logger::vverbose["watcher"] << "watching directory " << dir << std::endl;
+		this -> _dirs[dir].wd = wd;
+		this -> _wds[wd] = dir;
+	}
+
+	auto& files = this -> _dirs[dir].files;
+
+	if ( !files.contains(name))
+		files[name] = ++this -> _serial;
+
+	return files[name];
+}
+
+uint64_t WATCHER::generation(const std::string& path) {
+
+	if ( this -> _fd < 0 || path.empty())
+		return 0;
+
+	std::string dir, name;
+	split_path(path, dir, name);
+
+	std::lock_guard<std::mutex> lock(this -> _m);
+
+	if ( auto d = this -> _dirs.find(dir); d != this -> _dirs.end())
+		if ( auto f = d -> second.files.find(name); f != d -> second.files.end())
+			return f -> second;
+
+	return 0;
+}
+
+void WATCHER::process(const char *buf, size_t len) {
+
+	bool changed = false;
+	std::function<void()> notify;
+
+	{
+		std::lock_guard<std::mutex> lock(this -> _m);
+
+		for ( size_t i = 0; i + sizeof(struct inotify_event) <= len; ) {
+
+			const struct inotify_event *ev = (const struct inotify_event*)(buf + i);
+			i += sizeof(struct inotify_event) + ev -> len;
+
+			if ( ev -> mask & IN_Q_OVERFLOW ) {
+
+				// events were lost, treat everything as changed
+				for ( auto& [dir, d] : this -> _dirs )
+					for ( auto& [name, gen] : d.files )
+						gen = ++this -> _serial;
+
+				changed = true;
+				continue;
+			}
+
+			auto w = this -> _wds.find(ev -> wd);
+
+			if ( w == this -> _wds.end())
+				continue;
+
+			auto d = this -> _dirs.find(w -> second);
+
+			if ( ev -> mask & ( IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF )) {
+
+				// directory is gone; its files can no longer be watched, so
+				// forget them and let subscribers fall back to polling
+				if ( d != this -> _dirs.end()) {
+					inotify_rm_watch(this -> _fd, ev -> wd);
+					this -> _dirs.erase(d);
+				}
+
+				this -> _wds.erase(w);
+				changed = true;
+				continue;
+			}
+
+			if ( ev -> len == 0 || d == this -> _dirs.end())
+				continue;
+
+			if ( auto f = d -> second.files.find(ev -> name); f != d -> second.files.end()) {
+
+				f -> second = ++this -> _serial;
+				changed = true;
+				logger::vverbose["watcher"] << "file " << w -> second << "/" << ev -> name << " changed" << std::endl;
+			}
+		}
+
+		notify = this -> _notify;
+	}
+
+	if ( changed && notify )
+		notify();
+}
+
+void WATCHER::watch_loop(std::stop_token token) {
+
+	alignas(struct inotify_event) char buf[4096 + sizeof(struct inotify_event) + NAME_MAX + 1];
+	struct pollfd pfd = { .fd = this -> _fd, .events = POLLIN, .revents = 0 };
+
+	while ( !token.stop_requested()) {
+
+		if ( int r = poll(&pfd, 1, WATCH_POLL_MS); r <= 0 || !( pfd.revents & POLLIN ))
+			continue;
+
+		ssize_t len;
+
+		while (( len = ::read(this -> _fd, buf, sizeof(buf))) > 0 )
+			this -> process(buf, len);
+	}
+}
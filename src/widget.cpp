@@ -1,15 +1,21 @@
 #include <iostream>
 #include <memory>
+#include <atomic>
 
 #include "common.hpp"
 #include "logger.hpp"
 #include "widget_classes.hpp"
+#include "tick.hpp"
 
 std::vector<std::string> widget::types = {
 	"image", "ttf", "linechart", "curvechart", "bar", "gauge", "clock"
 };
 
+static std::atomic<uint64_t> generations{0};
+
 widget::WIDGET::WIDGET() {
+
+	this -> _generation = ++generations;
 }
 
 widget::WIDGET::~WIDGET() {
@@ -84,6 +90,47 @@ int widget::WIDGET::interval() {
 	return this -> _interval;
 }
 
+int widget::WIDGET::priority() {
+
+	if ( this -> _priority > -1 )
+		return this -> _priority;
+
+	int i = this -> P2I("priority", 0);
+	this -> _priority = i < 0 ? 0 : ( i > 10 ? 10 : i );
+	return this -> _priority;
+}
+
+TICK::ALIGN widget::WIDGET::sync() {
+
+	if ( this -> _sync > -1 )
+		return (TICK::ALIGN)this -> _sync;
+
+	TICK::ALIGN a = TICK::NONE;
+	std::string s = common::unquoted(common::to_lower(common::trim_ws(this -> P2S("sync", "none"))));
+
+	if ( !s.empty() && !TICK::parse(s, a))
+		logger::warning["config"] << "widget " << this -> _name << " has unknown sync '" << s << "', updates are not aligned" << std::endl;
+
+	if ( a != TICK::NONE && this -> use_cycles()) {
+
+		logger::warning["config"] << "widget " << this -> _name << " counts interval in cycles, sync is ignored" << std::endl;
+		a = TICK::NONE;
+	}
+
+	this -> _sync = a;
+	return a;
+}
+
+std::chrono::milliseconds widget::WIDGET::next_update() {
+
+	return TICK::next(this -> last_updated, this -> interval(), this -> sync());
+}
+
+bool widget::WIDGET::draws_ahead() const {
+
+	return false;
+}
+
 int widget::WIDGET::width() const {
 	return this -> _width;
 }
@@ -114,6 +161,18 @@ bool widget::WIDGET::needs_draw() const {
 	return this -> _needs_draw;
 }
 
+uint64_t widget::WIDGET::generation() const {
+	return this -> _generation;
+}
+
+bool widget::WIDGET::drawn() {
+
+	if ( this -> _needs_draw )
+		this -> _generation = ++generations;
+
+	return this -> _needs_draw;
+}
+
 unsigned char widget::convert_alpha(unsigned char gdAlpha) {
 	return gdAlpha == 127 ? 0 : ( 255 - 2 * gdAlpha );
 }
@@ -141,9 +200,8 @@ bool widget::WIDGET::time_to_update() {
 
 	} else {
 
-		auto now  = std::chrono::duration_cast<std::chrono::milliseconds>(
-			std::chrono::system_clock::now().time_since_epoch());
-		auto next = this -> last_updated + std::chrono::milliseconds(this -> interval());
+		auto now  = TICK::millis();
+		auto next = this -> next_update();
 
 		if ( now < next ) {
 			logger::debug["widget"] << this -> _name << ": " << (next - now).count()
@@ -158,6 +216,85 @@ bool widget::WIDGET::time_to_update() {
 	return true;
 }
 
+void widget::WIDGET::invalidate() {
+
+	this -> _needs_update = true;
+	this -> _inputs_valid = false;
+}
+
+// Drawing mode is an input of every widget
+bool widget::WIDGET::inputs_changed(const INPUTS& in) {
+
+	INPUTS mode = in;
+	mode << this -> _degraded;
+
+	bool changed = !this -> _inputs_valid || this -> _inputs != mode.hash() || this -> bitmap.empty();
+
+	this -> _inputs = mode.hash();
+	this -> _inputs_valid = true;
+
+	if ( !changed )
+		logger::debug["widget"] << this -> _name << ": inputs unchanged, not drawn" << std::endl;
+
+	return changed;
+}
+
+void widget::WIDGET::INPUTS::add(const void *data, size_t size) {
+
+	const unsigned char *p = (const unsigned char*)data;
+
+	for ( size_t i = 0; i < size; i++ ) {
+		this -> _hash ^= p[i];
+		this -> _hash *= 0x100000001b3ULL;
+	}
+}
+
+// Strings are terminated, so that consecutive values cannot run together
+widget::WIDGET::INPUTS& widget::WIDGET::INPUTS::operator <<(const std::string& s) {
+
+	this -> add(s.c_str(), s.size() + 1);
+	return *this;
+}
+
+widget::WIDGET::INPUTS& widget::WIDGET::INPUTS::operator <<(const char *s) {
+
+	return *this << std::string(s);
+}
+
+widget::WIDGET::INPUTS& widget::WIDGET::INPUTS::operator <<(int i) {
+
+	this -> add(&i, sizeof(i));
+	return *this;
+}
+
+widget::WIDGET::INPUTS& widget::WIDGET::INPUTS::operator <<(double d) {
+
+	this -> add(&d, sizeof(d));
+	return *this;
+}
+
+widget::WIDGET::INPUTS& widget::WIDGET::INPUTS::operator <<(bool b) {
+
+	unsigned char c = b ? 1 : 0;
+	this -> add(&c, 1);
+	return *this;
+}
+
+uint64_t widget::WIDGET::INPUTS::hash() const {
+
+	return this -> _hash;
+}
+
+std::function<void()> widget::WIDGET::preload() {
+
+	return {};
+}
+
+bool widget::WIDGET::degrade() {
+
+	return false;
+}
+
 void widget::add(const std::string& name, CONFIG::MAP *cfg) {
 
 	std::string _name = common::unquoted(common::to_lower(common::trim_ws(std::as_const(name))));
@@ -8,6 +8,7 @@
 #include "display.hpp"
 #include "fs_funcs.hpp"
 #include "expr/expression.hpp"
+#include "tick.hpp"
 #include "widgets/bar.hpp"
 
 widget::BAR::BAR(const std::string& name, CONFIG::MAP *cfg) {
@@ -25,7 +26,7 @@ widget::BAR::BAR(const std::string& name, CONFIG::MAP *cfg) {
 	std::vector<std::string> allowed_keys = {
 		"value", "low", "high", "min", "max", "color", "colorend", "colorlow", "colorhigh", "bgcolor",
 		"width", "height", "smooth", "hollow", "direction", "scale", "center", "opacity",
-		"inverted", "visible", "interval", "reload", "border", "bordercolor", "class", "type"
+		"inverted", "visible", "interval", "reload", "border", "bordercolor", "priority", "sync", "class", "type"
 	};
 
 	for ( auto& [k, v] : *cfg ) {
@@ -208,13 +209,46 @@ widget::BAR::~BAR() {
 	this -> _properties.clear();
 }
 
-// Reads the current value expression, applies optional smoothing (steps the
-// displayed value toward the real value by at most 'smooth' per update), clamps
-// to [min, max], and returns true if the value actually changed.
-bool widget::BAR::value_did_change() {
+void widget::BAR::evaluate(VALUES& v) {
+
+	v.min = this -> P2I("min", 0);
+	v.max = this -> P2I("max", 100);
+	v.value = this -> P2I("value", v.min);
+	v.smooth = this -> P2I("smooth", 0);
+	v.low = this -> P2I("low", -1);
+	v.high = this -> P2I("high", -1);
+	v.width = this -> P2I("width", 20);
+	v.height = this -> P2I("height", 10);
+	v.hollow = this -> P2B("hollow", false);
+	v.direction = this -> P2S("direction", "east");
+	v.scale = this -> P2N("scale", 1.0);
+	v.opacity = this -> P2N("opacity", 1.0);
+	v.inverted = this -> P2B("inverted", false);
+	v.color = this -> P2S("color", "ffffff");
+	v.colorend = this -> P2S("colorend", "");
+	v.colorlow = this -> P2S("colorlow", "000000");
+	v.colorhigh = this -> P2S("colorhigh", "000000");
+	v.bgcolor = this -> P2S("bgcolor", "444444");
+	v.border = this -> P2B("border", false);
+	v.bordercolor = this -> P2S("bordercolor", "");
+	v.center = this -> center();
+}
+
+// Raw value is left out, bar is drawn from the smoothed one
+void widget::BAR::VALUES::hash(INPUTS& in) const {
+
+	in << this -> low << this -> high << this -> min << this -> max << this -> width << this -> height <<
+		this -> direction << this -> color << this -> colorend << this -> colorlow << this -> colorhigh <<
+		this -> bgcolor << this -> bordercolor << this -> scale << this -> opacity << this -> hollow <<
+		this -> inverted << this -> border << this -> center;
+}
+
+// Applies optional smoothing to value (steps the displayed value toward the
+// real value by at most 'smooth' per update) and clamps it to [min, max].
+void widget::BAR::read_value(const VALUES& v) {
 
-	int val = this -> P2I("value", this -> P2I("min", 0));
-	int smoother = this -> P2I("smooth", 0);
+	int val = v.value;
+	int smoother = v.smooth;
 
 	if ( val != this -> value && smoother > 0 ) {
 
@@ -224,14 +258,12 @@ bool widget::BAR::value_did_change() {
 			val = this -> value - smoother;
 	}
 
-	if ( val < this -> P2I("min", 0))
-		val = this -> P2I("min", 0);
-	else if ( val > this -> P2I("max", 0))
-		val = this -> P2I("max", 0);
+	if ( val < v.min )
+		val = v.min;
+	else if ( val > v.max )
+		val = v.max;
 
-	bool did_change = val != this -> value;
 	this -> value = val;
-	return did_change;
 }
 
 bool widget::BAR::update() {
@@ -245,6 +277,7 @@ bool widget::BAR::update() {
 
 		std::fill(this -> bitmap.begin(), this -> bitmap.end(), RGBA(RGBA::TRANSPARENT));
 		this -> _was_visible = false;
+		this -> _inputs_valid = false;
 		this -> _needs_draw = true;
 
 	} else if ( !this -> visible() && !this -> _was_visible && !this -> bitmap.empty()) {
@@ -258,12 +291,24 @@ bool widget::BAR::update() {
 
 		this -> _needs_draw = false;
 
-	} else this -> _needs_draw = this -> value_did_change() ? this -> render() : false;
+	} else {
+
+		// smoothed value steps on every update until it reaches the real value
+		VALUES v;
+		INPUTS in;
+
+		this -> evaluate(v);
+		this -> read_value(v);
+		v.hash(in);
+		in << this -> value;
+
+		this -> _needs_draw = this -> inputs_changed(in) ? this -> render(v) : false;
+	}
 
 	this -> _needs_update = false;
-	this -> last_updated = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+	this -> last_updated = TICK::millis();
 
-	return this -> _needs_draw;
+	return this -> drawn();
 }
 
 // Maps a value in [min, max] to a percentage in [0, 99].
@@ -284,26 +329,26 @@ static unsigned char val_to_percent(unsigned char value, unsigned char min, unsi
 	return (unsigned char)pval;
 }
 
-bool widget::BAR::render() {
-
-	int p_low = this -> P2I("low", -1);
-	int p_high = this -> P2I("high", -1);
-	int p_min = this -> P2I("min", 0);
-	int p_max = this -> P2I("max", 100);
-	int p_width = this -> P2I("width", 20 ) < 20 ? 20 : this -> P2I("width", 20);
-	int p_height = this -> P2I("height", 10 ) < 10 ? 10: this -> P2I("height", 10);
-	bool p_hollow = this -> P2B("hollow", false);
-	std::string p_direction = this -> P2S("direction", "east");
-	double p_scale = this -> P2N("scale", 1.0);
-	double p_opacity = this -> P2N("opacity", 1.0);
-	bool p_inverted = this -> P2B("inverted", false);
-	std::string p_color = this -> P2S("color", "ffffff");
-	std::string p_colorend = this -> P2S("colorend", "");
-	std::string p_colorlow = this -> P2S("colorlow", "000000");
-	std::string p_colorhigh = this -> P2S("colorhigh", "000000");
-	std::string p_bgcolor = this -> P2S("bgcolor", "444444");
-	bool p_border = this -> P2B("border", false);
-	std::string p_bordercolor = this -> P2S("bordercolor", "");
+bool widget::BAR::render(const VALUES& v) {
+
+	int p_low = v.low;
+	int p_high = v.high;
+	int p_min = v.min;
+	int p_max = v.max;
+	int p_width = v.width < 20 ? 20 : v.width;
+	int p_height = v.height < 10 ? 10 : v.height;
+	bool p_hollow = v.hollow;
+	std::string p_direction = v.direction;
+	double p_scale = v.scale;
+	double p_opacity = v.opacity;
+	bool p_inverted = v.inverted;
+	std::string p_color = v.color;
+	std::string p_colorend = v.colorend;
+	std::string p_colorlow = v.colorlow;
+	std::string p_colorhigh = v.colorhigh;
+	std::string p_bgcolor = v.bgcolor;
+	bool p_border = v.border;
+	std::string p_bordercolor = v.bordercolor;
 	int g_fgcolor, g_bgcolor;
 
 	if ( p_width < 1 ) {
@@ -464,7 +509,7 @@ bool widget::BAR::render() {
 		}
 	}
 
-	if ( this -> center()) {
+	if ( v.center ) {
 
 		int ox = gdImageSX(gdImage);
 		int oy = gdImageSY(gdImage);
@@ -493,9 +538,7 @@ bool widget::BAR::render() {
 	// render
 	if ( this -> visible()) {
 
-		for ( int y = 0; y < this -> _height; y++ )
-			for ( int x = 0; x < this -> _width; x++ )
-				new_bitmap.push_back(RGBA(gdImageGetTrueColorPixel(gdImage, x, y), p_inverted, p_opacity));
+		RGBA::from_gd(gdImage, new_bitmap, p_inverted, p_opacity);
 
 	} else new_bitmap.assign(this -> _width * this -> _height, RGBA(RGBA::TRANSPARENT));
 
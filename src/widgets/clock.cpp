@@ -9,6 +9,7 @@
 #include "driver.hpp"
 #include "display.hpp"
 #include "expr/expression.hpp"
+#include "tick.hpp"
 #include "widgets/clock.hpp"
 
 widget::CLOCK::CLOCK(const std::string& name, CONFIG::MAP *cfg) {
@@ -29,7 +30,7 @@ widget::CLOCK::CLOCK(const std::string& name, CONFIG::MAP *cfg) {
 		"tickcolor", "ticks", "minuteticks",
 		"handwidth",
 		"width", "height",
-		"visible", "interval", "reload", "class", "type"
+		"visible", "interval", "reload", "priority", "sync", "class", "type"
 	};
 
 	for ( auto& [k, v] : *cfg ) {
@@ -103,6 +104,7 @@ bool widget::CLOCK::update() {
 
 		std::fill(this -> bitmap.begin(), this -> bitmap.end(), RGBA(RGBA::TRANSPARENT));
 		this -> _was_visible = false;
+		this -> _inputs_valid = false;
 		this -> _needs_draw = true;
 
 	} else if ( !this -> visible() && !this -> _was_visible && !this -> bitmap.empty()) {
@@ -118,13 +120,20 @@ bool widget::CLOCK::update() {
 
 	} else {
 
-		this -> _needs_draw = this -> render();
+		// a clock updated more often than its hands move is drawn only when they do
+		VALUES v;
+		INPUTS in;
+
+		this -> evaluate(v);
+		v.hash(in);
+
+		this -> _needs_draw = this -> inputs_changed(in) ? this -> render(v) : false;
 	}
 
 	this -> _needs_update = false;
-	this -> last_updated = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+	this -> last_updated = TICK::millis();
 
-	return this -> _needs_draw;
+	return this -> drawn();
 }
 
 // Compute the endpoint of a clock hand given center, length, and angle.
@@ -136,20 +145,61 @@ static void hand_tip(int cx, int cy, double length, double clock_angle_deg, int
 	*y = cy + (int)std::round(length * std::sin(rad));
 }
 
-bool widget::CLOCK::render() {
+void widget::CLOCK::evaluate(VALUES& v) {
+
+	// Local time of current frame
+	const std::tm& tm = TICK::local();
+
+	v.width = this -> P2I("width", 100);
+	v.height = this -> P2I("height", 100);
+	v.handwidth = this -> P2I("handwidth", 0);
+	v.ticks = this -> P2B("ticks", true);
+	v.minuteticks = this -> P2B("minuteticks", false);
+	v.facecolor = this -> P2S("facecolor", "1a1a2a");
+	v.rimcolor = this -> P2S("rimcolor", "666688");
+	v.hourcolor = this -> P2S("hourcolor", "ffffff");
+	v.minutecolor = this -> P2S("minutecolor", "cccccc");
+	v.secondcolor = this -> P2S("secondcolor", "ff4444");
+	v.tickcolor = this -> P2S("tickcolor", "888888");
+	v.hour = tm.tm_hour % 12;
+	v.minute = tm.tm_min;
+	v.second = tm.tm_sec;
+}
+
+void widget::CLOCK::VALUES::hash(INPUTS& in) const {
+
+	in << this -> width << this -> height << this -> handwidth << this -> hour << this -> minute <<
+		this -> second << this -> facecolor << this -> rimcolor << this -> hourcolor << this -> minutecolor <<
+		this -> secondcolor << this -> tickcolor << this -> ticks << this -> minuteticks;
+}
+
+// Hands are placed from local time of the tick only
+bool widget::CLOCK::draws_ahead() const {
+
+	return true;
+}
+
+// Hands are drawn without anti-aliasing
+bool widget::CLOCK::degrade() {
+
+	this -> _degraded = true;
+	return true;
+}
+
+bool widget::CLOCK::render(const VALUES& v) {
 
-	int p_width    = this -> P2I("width",  100) < 20 ? 20 : this -> P2I("width",  100);
-	int p_height   = this -> P2I("height", 100) < 20 ? 20 : this -> P2I("height", 100);
-	int p_handwidth = std::clamp(this -> P2I("handwidth", 0), 0, 8);
-	bool p_ticks        = this -> P2B("ticks",       true);
-	bool p_minuteticks  = this -> P2B("minuteticks", false);
+	int p_width    = v.width < 20 ? 20 : v.width;
+	int p_height   = v.height < 20 ? 20 : v.height;
+	int p_handwidth = std::clamp(v.handwidth, 0, 8);
+	bool p_ticks        = v.ticks;
+	bool p_minuteticks  = v.minuteticks;
 
-	std::string p_facecolor   = this -> P2S("facecolor",   "1a1a2a");
-	std::string p_rimcolor    = this -> P2S("rimcolor",    "666688");
-	std::string p_hourcolor   = this -> P2S("hourcolor",   "ffffff");
-	std::string p_minutecolor = this -> P2S("minutecolor", "cccccc");
-	std::string p_secondcolor = this -> P2S("secondcolor", "ff4444");
-	std::string p_tickcolor   = this -> P2S("tickcolor",   "888888");
+	std::string p_facecolor   = v.facecolor;
+	std::string p_rimcolor    = v.rimcolor;
+	std::string p_hourcolor   = v.hourcolor;
+	std::string p_minutecolor = v.minutecolor;
+	std::string p_secondcolor = v.secondcolor;
+	std::string p_tickcolor   = v.tickcolor;
 
 	if ( !RGBA::check_color(p_facecolor))   p_facecolor   = "1a1a2a";
 	if ( !RGBA::check_color(p_rimcolor))    p_rimcolor    = "666688";
@@ -165,12 +215,9 @@ bool widget::CLOCK::render() {
 	RGBA second_color(p_secondcolor);
 	RGBA tick_color(p_tickcolor);
 
-	// Read system time
-	std::time_t now_t = std::time(nullptr);
-	std::tm *tm = std::localtime(&now_t);
-	int hour   = tm -> tm_hour % 12;
-	int minute = tm -> tm_min;
-	int second = tm -> tm_sec;
+	int hour   = v.hour;
+	int minute = v.minute;
+	int second = v.second;
 
 	// Clock geometry
 	int diameter = std::min(p_width, p_height);
@@ -255,18 +302,19 @@ bool widget::CLOCK::render() {
 	hand_tip(cx, cy, minute_len, minute_angle, &mx, &my);
 	hand_tip(cx, cy, second_len, second_angle, &sx, &sy);
 
-	// Set antialiased color and draw hands, thickest first
+	// Set antialiased color and draw hands, thickest first; plain colour
+	// when degraded
 	gdImageSetAntiAliased(gdImage, g_hour);
 	gdImageSetThickness(gdImage, hour_thick);
-	gdImageLine(gdImage, cx, cy, hx, hy, gdAntiAliased);
+	gdImageLine(gdImage, cx, cy, hx, hy, this -> _degraded ? g_hour : gdAntiAliased);
 
 	gdImageSetAntiAliased(gdImage, g_minute);
 	gdImageSetThickness(gdImage, minute_thick);
-	gdImageLine(gdImage, cx, cy, mx, my, gdAntiAliased);
+	gdImageLine(gdImage, cx, cy, mx, my, this -> _degraded ? g_minute : gdAntiAliased);
 
 	gdImageSetAntiAliased(gdImage, g_second);
 	gdImageSetThickness(gdImage, 1);
-	gdImageLine(gdImage, cx, cy, sx, sy, gdAntiAliased);
+	gdImageLine(gdImage, cx, cy, sx, sy, this -> _degraded ? g_second : gdAntiAliased);
 
 	gdImageSetThickness(gdImage, 1);
 
@@ -281,9 +329,7 @@ bool widget::CLOCK::render() {
 
 	std::vector<RGBA> new_bitmap;
 
-	for ( int y = 0; y < this -> _height; y++ )
-		for ( int x = 0; x < this -> _width; x++ )
-			new_bitmap.push_back(RGBA(gdImageGetTrueColorPixel(gdImage, x, y), false, 1.0));
+	RGBA::from_gd(gdImage, new_bitmap);
 
 	gdImageDestroy(gdImage);
 
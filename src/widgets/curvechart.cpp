@@ -10,6 +10,7 @@
 #include "display.hpp"
 #include "fs_funcs.hpp"
 #include "expr/expression.hpp"
+#include "tick.hpp"
 #include "widgets/curvechart.hpp"
 
 // Catmull-Rom spline through P1..P2, t in [0,1]. P0 and P3 are the flanking
@@ -56,7 +57,7 @@ widget::CURVECHART::CURVECHART(const std::string& name, CONFIG::MAP *cfg) {
 		"width", "height",
 		"fill", "linewidth", "samples", "smooth",
 		"scale", "center", "opacity", "inverted", "visible",
-		"use_cycles", "interval", "reload", "class", "type"
+		"use_cycles", "interval", "reload", "priority", "sync", "class", "type"
 	};
 
 	for ( auto& [k, v] : *cfg ) {
@@ -219,9 +220,9 @@ bool widget::CURVECHART::update() {
 	}
 
 	this -> _needs_update = false;
-	this -> last_updated = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+	this -> last_updated = TICK::millis();
 
-	return this -> _needs_draw;
+	return this -> drawn();
 }
 
 bool widget::CURVECHART::render() {
@@ -417,9 +418,7 @@ bool widget::CURVECHART::render() {
 
 	if ( this -> visible()) {
 
-		for ( int y = 0; y < this -> _height; y++ )
-			for ( int x = 0; x < this -> _width; x++ )
-				new_bitmap.push_back(RGBA(gdImageGetTrueColorPixel(gdImage, x, y), p_inverted, p_opacity));
+		RGBA::from_gd(gdImage, new_bitmap, p_inverted, p_opacity);
 
 	} else new_bitmap.assign(this -> _width * this -> _height, RGBA(RGBA::TRANSPARENT));
 
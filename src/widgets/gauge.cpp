@@ -8,6 +8,7 @@
 #include "driver.hpp"
 #include "display.hpp"
 #include "expr/expression.hpp"
+#include "tick.hpp"
 #include "widgets/gauge.hpp"
 
 widget::GAUGE::GAUGE(const std::string& name, CONFIG::MAP *cfg) {
@@ -29,7 +30,7 @@ widget::GAUGE::GAUGE(const std::string& name, CONFIG::MAP *cfg) {
 		"low", "high", "colorlow", "colorhigh",
 		"width", "height", "linewidth",
 		"startangle", "sweepangle",
-		"visible", "interval", "reload", "class", "type"
+		"visible", "interval", "reload", "priority", "sync", "class", "type"
 	};
 
 	for ( auto& [k, v] : *cfg ) {
@@ -124,19 +125,34 @@ widget::GAUGE::~GAUGE() {
 	this -> _properties.clear();
 }
 
-// Reads and clamps the current value expression; returns true if the value changed.
-bool widget::GAUGE::value_did_change() {
-
-	int val = this -> P2I("value", this -> P2I("min", 0));
-	int p_min = this -> P2I("min", 0);
-	int p_max = this -> P2I("max", 100);
+// Value is clamped to [min, max]; linewidth is -1 when it follows size.
+void widget::GAUGE::evaluate(VALUES& v) {
+
+	v.min = this -> P2I("min", 0);
+	v.max = this -> P2I("max", 100);
+	v.value = std::clamp(this -> P2I("value", v.min), v.min, std::max(v.min, v.max));
+	v.width = this -> P2I("width", 100);
+	v.height = this -> P2I("height", 100);
+	v.startangle = this -> P2I("startangle", 225);
+	v.sweepangle = this -> P2I("sweepangle", 270);
+	v.needle = this -> P2B("needle", false);
+	v.low = this -> P2I("low", -1);
+	v.high = this -> P2I("high", -1);
+	v.linewidth = this -> P2I("linewidth", -1);
+	v.fgcolor = this -> P2S("fgcolor", "44cc44");
+	v.trackcolor = this -> P2S("trackcolor", "");
+	v.bgcolor = this -> P2S("bgcolor", "111111");
+	v.needlecolor = this -> P2S("needlecolor", "");
+	v.colorlow = this -> P2S("colorlow", "000000");
+	v.colorhigh = this -> P2S("colorhigh", "000000");
+}
 
-	if ( val < p_min ) val = p_min;
-	else if ( val > p_max ) val = p_max;
+void widget::GAUGE::VALUES::hash(INPUTS& in) const {
 
-	bool did_change = ( val != this -> value );
-	this -> value = val;
-	return did_change;
+	in << this -> value << this -> min << this -> max << this -> width << this -> height << this -> startangle <<
+		this -> sweepangle << this -> low << this -> high << this -> linewidth << this -> fgcolor <<
+		this -> trackcolor << this -> bgcolor << this -> needlecolor << this -> colorlow << this -> colorhigh <<
+		this -> needle;
 }
 
 bool widget::GAUGE::update() {
@@ -150,6 +166,7 @@ bool widget::GAUGE::update() {
 
 		std::fill(this -> bitmap.begin(), this -> bitmap.end(), RGBA(RGBA::TRANSPARENT));
 		this -> _was_visible = false;
+		this -> _inputs_valid = false;
 		this -> _needs_draw = true;
 
 	} else if ( !this -> visible() && !this -> _was_visible && !this -> bitmap.empty()) {
@@ -163,33 +180,43 @@ bool widget::GAUGE::update() {
 
 		this -> _needs_draw = false;
 
-	} else this -> _needs_draw = this -> value_did_change() ? this -> render() : false;
+	} else {
+
+		VALUES v;
+		INPUTS in;
+
+		this -> evaluate(v);
+		this -> value = v.value;
+		v.hash(in);
+
+		this -> _needs_draw = this -> inputs_changed(in) ? this -> render(v) : false;
+	}
 
 	this -> _needs_update = false;
-	this -> last_updated = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+	this -> last_updated = TICK::millis();
 
-	return this -> _needs_draw;
+	return this -> drawn();
 }
 
-bool widget::GAUGE::render() {
+bool widget::GAUGE::render(const VALUES& v) {
 
-	int p_min        = this -> P2I("min", 0);
-	int p_max        = this -> P2I("max", 100);
+	int p_min        = v.min;
+	int p_max        = v.max;
 	int p_value      = this -> value < p_min ? p_min : ( this -> value > p_max ? p_max : this -> value );
-	int p_width      = this -> P2I("width", 100) < 20 ? 20 : this -> P2I("width", 100);
-	int p_height     = this -> P2I("height", 100) < 20 ? 20 : this -> P2I("height", 100);
-	int p_startangle = this -> P2I("startangle", 225);
-	int p_sweepangle = std::clamp(this -> P2I("sweepangle", 270), 10, 360);
-	bool p_needle    = this -> P2B("needle", false);
-	int p_low        = this -> P2I("low", -1);
-	int p_high       = this -> P2I("high", -1);
-
-	std::string p_fgcolor     = this -> P2S("fgcolor",     "44cc44");
-	std::string p_trackcolor  = this -> P2S("trackcolor",  "");
-	std::string p_bgcolor     = this -> P2S("bgcolor",     "111111");
-	std::string p_needlecolor = this -> P2S("needlecolor", "");
-	std::string p_colorlow    = this -> P2S("colorlow",    "000000");
-	std::string p_colorhigh   = this -> P2S("colorhigh",   "000000");
+	int p_width      = v.width < 20 ? 20 : v.width;
+	int p_height     = v.height < 20 ? 20 : v.height;
+	int p_startangle = v.startangle;
+	int p_sweepangle = std::clamp(v.sweepangle, 10, 360);
+	bool p_needle    = v.needle;
+	int p_low        = v.low;
+	int p_high       = v.high;
+
+	std::string p_fgcolor     = v.fgcolor;
+	std::string p_trackcolor  = v.trackcolor;
+	std::string p_bgcolor     = v.bgcolor;
+	std::string p_needlecolor = v.needlecolor;
+	std::string p_colorlow    = v.colorlow;
+	std::string p_colorhigh   = v.colorhigh;
 
 	if ( !RGBA::check_color(p_fgcolor)) p_fgcolor = "44cc44";
 	if ( !RGBA::check_color(p_bgcolor)) p_bgcolor = "111111";
@@ -223,7 +250,7 @@ bool widget::GAUGE::render() {
 	int cy          = p_height / 2;
 	int radius      = diameter / 2;
 
-	int p_linewidth = this -> P2I("linewidth", std::max(4, diameter / 7));
+	int p_linewidth = v.linewidth < 0 ? std::max(4, diameter / 7) : v.linewidth;
 	p_linewidth = std::clamp(p_linewidth, 2, radius - 1);
 
 	int inner_radius   = radius - p_linewidth;
@@ -286,9 +313,7 @@ bool widget::GAUGE::render() {
 
 	std::vector<RGBA> new_bitmap;
 
-	for ( int y = 0; y < this -> _height; y++ )
-		for ( int x = 0; x < this -> _width; x++ )
-			new_bitmap.push_back(RGBA(gdImageGetTrueColorPixel(gdImage, x, y), false, 1.0));
+	RGBA::from_gd(gdImage, new_bitmap);
 
 	gdImageDestroy(gdImage);
 
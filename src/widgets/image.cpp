@@ -1,5 +1,9 @@
 #include <gd.h>
 #include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "logger.hpp"
 #include "throws.hpp"
@@ -8,6 +12,8 @@
 #include "display.hpp"
 #include "fs_funcs.hpp"
 #include "expr/expression.hpp"
+#include "trace.hpp"
+#include "tick.hpp"
 #include "widgets/image.hpp"
 
 widget::IMAGE::IMAGE(const std::string& name, CONFIG::MAP *cfg) {
@@ -24,7 +30,7 @@ widget::IMAGE::IMAGE(const std::string& name, CONFIG::MAP *cfg) {
 
 	std::vector<std::string> allowed_keys = {
 		"file", "width", "height", "scale", "visible", "inverted",
-		"center", "opacity", "reload", "interval", "class", "type"
+		"center", "opacity", "reload", "interval", "priority", "sync", "class", "type"
 	};
 
 	for ( auto& [k, v] : *cfg ) {
@@ -69,6 +75,11 @@ bool widget::IMAGE::update() {
 
 	std::string filename;
 
+	// watched file was rewritten or replaced, reload without waiting for interval
+	if ( !this -> _needs_update && this -> _watch_generation != 0 && display != nullptr && display -> watcher != nullptr &&
+		display -> watcher -> generation(this -> _watch_path) != this -> _watch_generation )
+		this -> _needs_update = true;
+
 	if ( !this -> _needs_update && this -> reloads() && this -> interval() > 0 && this -> time_to_update())
 		this -> _needs_update = true;
 	else if ( !this -> _needs_update )
@@ -110,76 +121,194 @@ bool widget::IMAGE::update() {
 	}
 
 	this -> _needs_update = false;
-	this -> last_updated = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+	this -> last_updated = TICK::millis();
+
+	return this -> drawn();
+}
 
-	return this -> _needs_draw;
+enum class IMAGE_FORMAT { UNKNOWN, PNG, JPEG, GIF, BMP };
+
+// Identifies the image format from its leading magic bytes, so that exactly
+// one decoder is tried instead of probing each of them in turn.
+static IMAGE_FORMAT detect_format(const std::vector<unsigned char>& data) {
+
+	if ( data.size() >= 8 && std::memcmp(data.data(), "\x89PNG\r\n\x1a\n", 8) == 0 )
+		return IMAGE_FORMAT::PNG;
+	else if ( data.size() >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff )
+		return IMAGE_FORMAT::JPEG;
+	else if ( data.size() >= 6 && ( std::memcmp(data.data(), "GIF87a", 6) == 0 || std::memcmp(data.data(), "GIF89a", 6) == 0 ))
+		return IMAGE_FORMAT::GIF;
+	else if ( data.size() >= 2 && data[0] == 'B' && data[1] == 'M' )
+		return IMAGE_FORMAT::BMP;
+
+	return IMAGE_FORMAT::UNKNOWN;
 }
 
-// Opens filename for binary reading into *fd. Returns false and logs on failure.
-// The format detector in render() calls this once per image type it tries.
-static bool open_file(FILE **fd, const std::string& filename, const std::string& name) {
+// Reads filename into data with a single open/read. Returns false and logs on failure.
+static bool read_file(const std::string& filename, const std::string& name, std::vector<unsigned char>& data) {
+
+	int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat st;
 
-	if ( *fd = fopen(filename.c_str(), "rb"); *fd == nullptr ) {
+	if ( fd < 0 || fstat(fd, &st) != 0 ) {
 
-		logger::error["widget"] << "Image " << name << ": fopen(" << filename << ") failed: " <<
+		logger::error["widget"] << "Image " << name << ": open(" << filename << ") failed: " <<
 			std::strerror(errno) << std::endl;
 
+		if ( fd >= 0 )
+			::close(fd);
 		return false;
 	}
 
+	data.resize(st.st_size);
+	size_t pos = 0;
+
+	while ( pos < data.size()) {
+
+		ssize_t n = ::read(fd, data.data() + pos, data.size() - pos);
+
+		if ( n < 0 && errno == EINTR )
+			continue;
+		else if ( n <= 0 )
+			break;
+
+		pos += n;
+	}
+
+	::close(fd);
+	data.resize(pos);
 	return true;
 }
 
 bool widget::IMAGE::render(const std::string& filename) {
 
-	bool p_inverted = this -> P2B("inverted", false);
-	int p_width = this -> P2I("width", 0);
-	int p_height = this -> P2I("height", 0);
-	double p_scale = this -> P2N("scale", 1.0);
-	double p_opacity = this -> P2N("opacity", 1.0);
+	IMAGE_CACHE::KEY key;
 
-	FILE *fd = nullptr;
-	std::vector<RGBA> new_bitmap;
-	gdImagePtr gdImage;
+	// subscribe before stat, so a write racing with this render is not missed
+	if ( display != nullptr && display -> watcher != nullptr ) {
+		this -> _watch_path = filename;
+		this -> _watch_generation = display -> watcher -> subscribe(filename);
+	}
+
+	if ( !this -> make_key(filename, key)) {
 
-	if ( !open_file(&fd, filename, this -> _name))
+		logger::error["widget"] << "Image " << this -> _name << ": stat(" << filename << ") failed" << std::endl;
 		return false;
+	}
 
-	gdImage = gdImageCreateFromPng(fd);
-	fclose(fd);
+	// file and output properties unchanged since last render, nothing to do
+	if ( this -> _image != nullptr && this -> _was_visible && this -> visible() && this -> _key == key )
+		return false;
 
-	if ( gdImage == nullptr ) {
+	std::shared_ptr<const IMAGE_CACHE::ENTRY> image = IMAGE_CACHE::find(key);
+
+	if ( image == nullptr ) {
 
-		if ( !open_file(&fd, filename, this -> _name))
+		if ( image = this -> decode(filename, key); image == nullptr )
 			return false;
 
-		gdImage = gdImageCreateFromJpeg(fd);
-		fclose(fd);
+		IMAGE_CACHE::store(key, image);
 	}
 
-	if ( gdImage == nullptr ) {
+	this -> _key = key;
+	this -> _image = image;
 
-		if ( !open_file(&fd, filename, this -> _name))
-			return false;
+	this -> _pwidth = this -> _width;
+	this -> _pheight = this -> _height;
+
+	this -> _width = image -> width;
+	this -> _height = image -> height;
 
-		gdImage = gdImageCreateFromGif(fd);
-		fclose(fd);
+	if ( !this -> visible()) {
+
+		std::vector<RGBA> new_bitmap(this -> _width * this -> _height, RGBA(RGBA::TRANSPARENT));
+
+		if ( this -> bitmap != new_bitmap ) {
+			this -> bitmap = new_bitmap;
+			this -> _was_visible = false;
+			return true;
+		}
+
+	} else if ( this -> bitmap != image -> bitmap ) {
+		this -> bitmap = image -> bitmap;
+		this -> _was_visible = true;
+		return true;
 	}
 
-	if ( gdImage == nullptr ) {
+	return false;
+}
 
-		if ( !open_file(&fd, filename, this -> _name))
-			return false;
+// Identity of filename and current output properties.
+bool widget::IMAGE::make_key(const std::string& filename, IMAGE_CACHE::KEY& key) {
+
+	if ( !IMAGE_CACHE::stat(filename, key))
+		return false;
+
+	key.width = this -> P2I("width", 0);
+	key.height = this -> P2I("height", 0);
+	key.scale = this -> P2N("scale", 1.0);
+	key.inverted = this -> P2B("inverted", false);
+	key.opacity = this -> P2N("opacity", 1.0);
+	key.center = this -> center() ? display -> width() : 0;
+	return true;
+}
+
+// Decodes image into the image cache, where the first update finds it.
+std::function<void()> widget::IMAGE::preload() {
+
+	std::string filename = this -> P2S("file", "");
+	IMAGE_CACHE::KEY key;
+
+	if ( !this -> visible() || filename.empty() || !fs::is_accessible(filename) ||
+		!this -> make_key(filename, key) || IMAGE_CACHE::find(key) != nullptr )
+		return {};
 
-		gdImage = gdImageCreateFromBmp(fd);
-		fclose(fd);
+	return [this, filename, key]() {
+
+		TRACE_SPAN("preload", this -> _name);
+
+		if ( auto image = this -> decode(filename, key); image != nullptr )
+			IMAGE_CACHE::store(key, image);
+	};
+}
+
+std::shared_ptr<const IMAGE_CACHE::ENTRY> widget::IMAGE::decode(const std::string& filename, const IMAGE_CACHE::KEY& key) {
+
+	bool p_inverted = key.inverted;
+	int p_width = key.width;
+	int p_height = key.height;
+	double p_scale = key.scale;
+	double p_opacity = key.opacity;
+
+	std::vector<unsigned char> data;
+	gdImagePtr gdImage = nullptr;
+
+	if ( !read_file(filename, this -> _name, data))
+		return nullptr;
+
+	switch ( detect_format(data)) {
+		case IMAGE_FORMAT::PNG:
+			gdImage = gdImageCreateFromPngPtr(data.size(), data.data());
+			break;
+		case IMAGE_FORMAT::JPEG:
+			gdImage = gdImageCreateFromJpegPtr(data.size(), data.data());
+			break;
+		case IMAGE_FORMAT::GIF:
+			gdImage = gdImageCreateFromGifPtr(data.size(), data.data());
+			break;
+		case IMAGE_FORMAT::BMP:
+			gdImage = gdImageCreateFromBmpPtr(data.size(), data.data());
+			break;
+		default:
+			logger::error["widget"] << "Image " << this -> _name << ": " << filename <<
+				" is not a PNG, JPEG, GIF or BMP image" << std::endl;
+			return nullptr;
 	}
 
 	if ( gdImage == nullptr ) {
 
-		logger::error["widget"] << "Image " << this -> _name << ": CreateFromPng/Jpeg/Gif/Bmp (" << filename <<
-			") failed" << std::endl;
-		return false;
+		logger::error["widget"] << "Image " << this -> _name << ": failed to decode " << filename << std::endl;
+		return nullptr;
 	}
 
 	if (( p_width > 0 || p_height > 0 ) && ( p_scale == 1.0 || p_scale == 0 )) {
@@ -247,14 +376,14 @@ bool widget::IMAGE::render(const std::string& filename) {
 		}
 	}
 
-	if ( this -> center()) {
+	if ( key.center > 0 ) {
 
 		int ox = gdImageSX(gdImage);
 		int oy = gdImageSY(gdImage);
-		int cx = ( display -> width() * 0.5 ) - ( ox * 0.5 );
+		int cx = ( key.center * 0.5 ) - ( ox * 0.5 );
 		int cy = 0;
 
-		gdImagePtr center_image = gdImageCreateTrueColor(display -> width(), oy);
+		gdImagePtr center_image = gdImageCreateTrueColor(key.center, oy);
 
 		if ( center_image == nullptr )
 			logger::error["widget"] << "Image " << this -> _name << ": CreateTrueColor (center) failed" << std::endl;
@@ -267,28 +396,15 @@ bool widget::IMAGE::render(const std::string& filename) {
 		}
 	}
 
-	this -> _pwidth = this -> _width;
-	this -> _pheight = this -> _height;
-
-	this -> _width = gdImage -> sx;
-	this -> _height = gdImage -> sy;
+	std::shared_ptr<IMAGE_CACHE::ENTRY> entry = std::make_shared<IMAGE_CACHE::ENTRY>();
 
-	// render
-	if ( this -> visible()) {
+	entry -> width = gdImage -> sx;
+	entry -> height = gdImage -> sy;
+	entry -> bitmap.reserve(entry -> width * entry -> height);
 
-		for ( int y = 0; y < this -> _height; y++ )
-			for ( int x = 0; x < this -> _width; x++ )
-				new_bitmap.push_back(RGBA(gdImageGetTrueColorPixel(gdImage, x, y), p_inverted, p_opacity));
-
-	} else new_bitmap.assign(this -> _width * this -> _height, RGBA(RGBA::TRANSPARENT));
+	RGBA::from_gd(gdImage, entry -> bitmap, p_inverted, p_opacity);
 
 	gdImageDestroy(gdImage);
 
-	if ( this -> bitmap != new_bitmap ) {
-		this -> bitmap = new_bitmap;
-		this -> _was_visible = this -> visible();
-		return true;
-	}
-
-	return false;
+	return entry;
 }
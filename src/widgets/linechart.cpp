@@ -8,6 +8,7 @@
 #include "display.hpp"
 #include "fs_funcs.hpp"
 #include "expr/expression.hpp"
+#include "tick.hpp"
 #include "widgets/linechart.hpp"
 
 widget::LINECHART::LINECHART(const std::string& name, CONFIG::MAP *cfg) {
@@ -25,7 +26,7 @@ widget::LINECHART::LINECHART(const std::string& name, CONFIG::MAP *cfg) {
 	std::vector<std::string> allowed_keys = {
 		"value", "min", "max", "fgcolor", "fgcolor2", "bgcolor", "gridlines", "gridcolor",
 		"width", "height", "smooth", "scale",
-		"center", "opacity", "inverted", "visible", "use_cycles", "interval", "reload", "class", "type"
+		"center", "opacity", "inverted", "visible", "use_cycles", "interval", "reload", "priority", "sync", "class", "type"
 	};
 
 	for ( auto& [k, v] : *cfg ) {
@@ -174,9 +175,9 @@ bool widget::LINECHART::update() {
 	}
 
 	this -> _needs_update = false;
-	this -> last_updated = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+	this -> last_updated = TICK::millis();
 
-	return this -> _needs_draw;
+	return this -> drawn();
 }
 
 static unsigned char val_to_percent(unsigned char value, unsigned char min, unsigned char max) {
@@ -405,9 +406,7 @@ bool widget::LINECHART::render() {
 	// render
 	if ( this -> visible()) {
 
-		for ( int y = 0; y < this -> _height; y++ )
-			for ( int x = 0; x < this -> _width; x++ )
-				new_bitmap.push_back(RGBA(gdImageGetTrueColorPixel(gdImage, x, y), p_inverted, p_opacity));
+		RGBA::from_gd(gdImage, new_bitmap, p_inverted, p_opacity);
 
 	} else new_bitmap.assign(this -> _width * this -> _height, RGBA(RGBA::TRANSPARENT));
 
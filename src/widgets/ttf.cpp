@@ -9,6 +9,8 @@
 #include "fs_funcs.hpp"
 #include "rgb.hpp"
 #include "expr/expression.hpp"
+#include "trace.hpp"
+#include "tick.hpp"
 #include "widgets/ttf.hpp"
 
 struct TTF_RECT {
@@ -61,7 +63,7 @@ widget::TTF::TTF(const std::string& name, CONFIG::MAP *cfg) {
 		"scale", "inverted", "opacity", "center", "debugborder", "debugbordercolor",
 		"shadow", "shadowcolor", "shadowoffset",
 		"outline", "outlinecolor",
-		"visible", "reload", "interval", "class", "type"
+		"visible", "reload", "interval", "priority", "sync", "class", "type"
 	};
 
 	for ( auto& [k, v] : *cfg ) {
@@ -123,6 +125,7 @@ bool widget::TTF::update() {
 
 		std::fill(this -> bitmap.begin(), this -> bitmap.end(), RGBA(RGBA::TRANSPARENT));
 		this -> _was_visible = false;
+		this -> _inputs_valid = false;
 		this -> _needs_draw = true;
 
 	} else if ( !this -> visible() && !this -> _was_visible && !this -> bitmap.empty()) {
@@ -138,8 +141,11 @@ bool widget::TTF::update() {
 
 	} else {
 
-		std::string text = this -> P2S("text", "");
-		std::string font = this -> P2S("font", "");
+		VALUES v;
+		this -> evaluate(v);
+
+		const std::string& text = v.text;
+		const std::string& font = v.font;
 
 		if ( text.empty()) {
 
@@ -157,34 +163,99 @@ bool widget::TTF::update() {
 			logger::vverbose["widget"] << "check permissions of font file " << font << "?" << std::endl;
 			this -> _needs_draw = false;
 
-		} else this -> _needs_draw = this -> render(text, font);
+		} else {
+
+			INPUTS in;
+			v.hash(in);
+			this -> _needs_draw = this -> inputs_changed(in) ? this -> render(v) : false;
+		}
 	}
 
 	this -> _needs_update = false;
-	this -> last_updated = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+	this -> last_updated = TICK::millis();
+
+	return this -> drawn();
+}
 
-	return this -> _needs_draw;
+void widget::TTF::evaluate(VALUES& v) {
+
+	v.text = this -> P2S("text", "");
+	v.font = this -> P2S("font", "");
+	v.size = this -> P2N("size", 12.0);
+	v.color = this -> P2S("color", "ffffff");
+	v.width = this -> P2I("width", 0);
+	v.height = this -> P2I("height", 0);
+	v.align = this -> P2S("align", "left");
+	v.offset = this -> P2I("offset", 0);
+	v.scale = this -> P2N("scale", 1.0);
+	v.inverted = this -> P2B("inverted", false);
+	v.opacity = this -> P2N("opacity", 1.0);
+	v.debugborder = this -> P2B("debugborder", false);
+	v.debugbordercolor = this -> P2S("debugbordercolor", "ffffff");
+	v.shadow = this -> P2B("shadow", false);
+	v.shadowcolor = this -> P2S("shadowcolor", "000000");
+	v.shadowoffset = this -> P2I("shadowoffset", 2);
+	v.outline = this -> P2B("outline", false);
+	v.outlinecolor = this -> P2S("outlinecolor", "000000");
+	v.center = this -> center();
 }
 
-bool widget::TTF::render(const std::string& text, const std::string& font) {
+void widget::TTF::VALUES::hash(INPUTS& in) const {
+
+	in << this -> text << this -> font << this -> color << this -> align << this -> debugbordercolor <<
+		this -> shadowcolor << this -> outlinecolor << this -> size << this -> scale << this -> opacity <<
+		this -> width << this -> height << this -> offset << this -> shadowoffset << this -> inverted <<
+		this -> debugborder << this -> shadow << this -> outline << this -> center;
+}
+
+// Text is drawn without anti-aliasing, shadow and outline
+bool widget::TTF::degrade() {
+
+	this -> _degraded = true;
+	return true;
+}
 
+// Loads font face at widget's size into gd's font cache; the cache is set
+// up here, on the calling thread, as setting it up is not thread safe.
+std::function<void()> widget::TTF::preload() {
+
+	std::string font = this -> P2S("font", "");
 	double p_size = this -> P2N("size", 12.0);
-	std::string p_color = this -> P2S("color", "ffffff");
-	int p_width = this -> P2I("width", 0);
-	int p_height = this -> P2I("height", 0);
-	std::string p_align = this -> P2S("align", "left");
-	int p_offset = this -> P2I("offset", 0);
-	double p_scale = this -> P2N("scale", 1.0);
-	bool p_inverted = this -> P2B("inverted", false);
-	double p_opacity = this -> P2N("opacity", 1.0);
-	bool p_debugborder = this -> P2B("debugborder", false);
-	std::string p_debugbordercolor = this -> P2S("debugbordercolor", "ffffff");
-
-	bool p_shadow = this -> P2B("shadow", false);
-	std::string p_shadowcolor = this -> P2S("shadowcolor", "000000");
-	int p_shadowoffset = this -> P2I("shadowoffset", 2);
-	bool p_outline = this -> P2B("outline", false);
-	std::string p_outlinecolor = this -> P2S("outlinecolor", "000000");
+
+	if ( !this -> visible() || font.empty() || !fs::is_accessible(font) || gdFontCacheSetup() != 0 )
+		return {};
+
+	return [this, font, p_size]() {
+
+		TRACE_SPAN("preload", this -> _name);
+		TTF_RECT rect;
+
+		if ( char *err = gdImageStringTTF(NULL, rect.gd(), 0, font.c_str(), p_size, 0., 0, 0, "Ag"); err != nullptr )
+			logger::error["widget"] << "ttf " << this -> _name << ": failed to load font " << font << ": " << err << std::endl;
+	};
+}
+
+bool widget::TTF::render(const VALUES& v) {
+
+	const std::string& text = v.text;
+	const std::string& font = v.font;
+	double p_size = v.size;
+	std::string p_color = v.color;
+	int p_width = v.width;
+	int p_height = v.height;
+	std::string p_align = v.align;
+	int p_offset = v.offset;
+	double p_scale = v.scale;
+	bool p_inverted = v.inverted;
+	double p_opacity = v.opacity;
+	bool p_debugborder = v.debugborder;
+	std::string p_debugbordercolor = v.debugbordercolor;
+
+	bool p_shadow = v.shadow;
+	std::string p_shadowcolor = v.shadowcolor;
+	int p_shadowoffset = v.shadowoffset;
+	bool p_outline = v.outline;
+	std::string p_outlinecolor = v.outlinecolor;
 
 	std::string m_text = "[Äp}§|";
 
@@ -290,8 +361,9 @@ bool widget::TTF::render(const std::string& text, const std::string& font) {
 	y += t_height * 0.12;
 	x += -1 + p_offset;
 
-	// Shadow: draw text offset behind main text
-	if ( p_shadow ) {
+	// Shadow: draw text offset behind main text; space for shadow and
+	// outline is kept when they are skipped, so that size stays the same
+	if ( p_shadow && !this -> _degraded ) {
 
 		if ( !RGBA::check_color(p_shadowcolor)) p_shadowcolor = "000000";
 		RGBA shadow_rgba(p_shadowcolor);
@@ -300,7 +372,7 @@ bool widget::TTF::render(const std::string& text, const std::string& font) {
 	}
 
 	// Outline: draw text at 8 surrounding pixel offsets, then main text on top
-	if ( p_outline ) {
+	if ( p_outline && !this -> _degraded ) {
 
 		if ( !RGBA::check_color(p_outlinecolor)) p_outlinecolor = "000000";
 		RGBA outline_rgba(p_outlinecolor);
@@ -314,7 +386,8 @@ bool widget::TTF::render(const std::string& text, const std::string& font) {
 
 	gdImageSetAntiAliased(gdImage, f_color);
 
-	if ( err = gdImageStringTTF(gdImage, b_rect.gd(), f_color, font.c_str(), p_size, 0.0, x, y, text.c_str()); err != nullptr ) {
+	// negative colour index draws without anti-aliasing
+	if ( err = gdImageStringTTF(gdImage, b_rect.gd(), this -> _degraded ? -f_color : f_color, font.c_str(), p_size, 0.0, x, y, text.c_str()); err != nullptr ) {
 
 		logger::error["widget"] << "ttf " << this -> _name << ": text render error: " << err << std::endl;
 		gdImageDestroy(gdImage);
@@ -350,7 +423,7 @@ bool widget::TTF::render(const std::string& text, const std::string& font) {
 		}
 	}
 
-	if ( this -> center()) {
+	if ( v.center ) {
 
 		int ox = gdImageSX(gdImage);
 		int oy = gdImageSY(gdImage);
@@ -379,9 +452,7 @@ bool widget::TTF::render(const std::string& text, const std::string& font) {
 	// render
 	if ( this -> visible()) {
 
-		for ( int y = 0; y < this -> _height; y++ )
-			for ( int x = 0; x < this -> _width; x++ )
-				new_bitmap.push_back(RGBA(gdImageGetTrueColorPixel(gdImage, x, y), p_inverted, p_opacity));
+		RGBA::from_gd(gdImage, new_bitmap, p_inverted, p_opacity);
 
 	} else new_bitmap.assign(this -> _width * this -> _height, RGBA(RGBA::TRANSPARENT));
 